@@ -0,0 +1,1379 @@
+#include <asm_gen.hpp>
+#include <stmt.hpp>
+#include <expr.hpp>
+#include <token.hpp>
+#include <data_type.hpp>
+#include <error.hpp>
+#include <math.hpp>
+#include <ir.hpp>
+
+#include <string>
+#include <profile.hpp>
+
+#define error_expr(e, fmt, ...) error_expr(this, e, fmt, ##__VA_ARGS__)
+#define error_data_type(d, fmt, ...) error_data_type(this, d, fmt, ##__VA_ARGS__)
+#define error_token(t, fmt, ...) error_token(this, t, fmt, ##__VA_ARGS__)
+
+#define STRING_PREFIX "_ether_str"
+
+static const char* reg_names[ASM_REG_COUNT][4] = {
+	{ "al", "ax", "eax", "rax" },
+	{ "cl", "cx", "ecx", "rcx" },
+	{ "dl", "dx", "edx", "rdx" },
+	{ "bl", "bx", "ebx", "rbx" },
+	{ "sil", "si", "esi", "rsi" },
+	{ "dil", "di", "edi", "rdi" },
+	{ "r8b", "r8w", "r8d", "r8" },
+	{ "r9b", "r9w", "r9d", "r9" },
+	{ "r10b", "r10w", "r10d", "r10" },
+	{ "r11b", "r11w", "r11d", "r11" },
+	{ "r12b", "r12w", "r12d", "r12" },
+	{ "r13b", "r13w", "r13d", "r13" },
+	{ "r14b", "r14w", "r14d", "r14" },
+	{ "r15b", "r15w", "r15d", "r15" },
+	{ "bpl", "bp", "ebp", "rbp" },
+};
+
+static const int arg_regs[ASM_ARG_REG_COUNT] = {
+	ASM_RDI, ASM_RSI, ASM_RDX, ASM_RCX, ASM_R8, ASM_R9,
+};
+
+/* rax, rcx and rdx are never allocated; they hold operands that live
+ * in the frame, and division and shifts need them */
+#define CALLEE_SAVED_COUNT 5
+#define CALLER_SAVED_COUNT 6
+
+static const int callee_saved_regs[CALLEE_SAVED_COUNT] = {
+	ASM_RBX, ASM_R12, ASM_R13, ASM_R14, ASM_R15,
+};
+
+static const int caller_saved_regs[CALLER_SAVED_COUNT] = {
+	ASM_RSI, ASM_RDI, ASM_R8, ASM_R9, ASM_R10, ASM_R11,
+};
+
+static const char* size_names[4] = { "byte", "word", "dword", "qword" };
+
+static u64 size_index(u64 size) {
+	switch (size) {
+	case 1: return 0;
+	case 2: return 1;
+	case 4: return 2;
+	default: return 3;
+	}
+}
+
+static u64 align_up(u64 n, u64 align) {
+	return (n + align - 1) / align * align;
+}
+
+static void write_formatted(Writer* writer, const char* fmt, va_list ap) {
+	char str[256];
+	va_list aq;
+	va_copy(aq, ap);
+	int len = vsnprintf(str, sizeof(str), fmt, ap);
+	if (len < (int)sizeof(str)) {
+		writer_write(writer, str, len);
+	}
+	else {
+		char* long_str = (char*)malloc(len + 1);
+		vsnprintf(long_str, len + 1, fmt, aq);
+		writer_write(writer, long_str, len);
+		free(long_str);
+	}
+	va_end(aq);
+}
+
+/* the condition a comparison sets, or its negation */
+static const char* cond_code(IrOp op, bool is_signed, bool negate) {
+	switch (op) {
+	case IR_EQ: return negate ? "ne" : "e";
+	case IR_NE: return negate ? "e" : "ne";
+	case IR_LT: return negate ? (is_signed ? "ge" : "ae") : (is_signed ? "l" : "b");
+	case IR_LE: return negate ? (is_signed ? "g" : "a") : (is_signed ? "le" : "be");
+	case IR_GT: return negate ? (is_signed ? "le" : "be") : (is_signed ? "g" : "a");
+	case IR_GE: return negate ? (is_signed ? "l" : "b") : (is_signed ? "ge" : "ae");
+	default:
+		assert(0);
+		return null;
+	}
+}
+
+error_code AsmGenerator::generate(Stmt** _stmts, IrUnit* unit, char* _output_fpath) {
+	stmts = _stmts;
+	output_fpath = _output_fpath;
+	structs = {};
+	layouts = {};
+	field_offsets = {};
+	function = null;
+	operand_buf = 0;
+	label_count = 0;
+	strings = null;
+	error_count = 0;
+
+	if (writer_open(&writer, output_fpath) == ETHER_ERROR) {
+		return ETHER_ERROR;
+	}
+
+	output_mutex.lock();
+	printf("Generating %s...\n", output_fpath);
+	output_mutex.unlock();
+
+	buf_loop(stmts, s) {
+		Stmt* stmt = stmts[s];
+		if (stmt->type == S_STRUCT &&
+			!map_get(&structs, stmt->struct_stmt.identifier->lexeme)) {
+			map_put(&structs, stmt->struct_stmt.identifier->lexeme, stmt);
+		}
+	}
+
+	emit_raw("bits 64\n"
+			 "default rel\n"
+			 "\n");
+
+	/* functions that are not pub stay in this unit, like the static
+	 * functions of the C backend */
+	buf_loop(stmts, s) {
+		Stmt* stmt = stmts[s];
+		if (stmt->type == S_FUNC_DECL) {
+			bool is_main = (!stmt->func_decl.struct_in &&
+							stmt->func_decl.identifier->lexeme == names.main);
+			if (!stmt->func_decl.is_function) {
+				emit_raw("extern %s\n", func_symbol(stmt));
+			}
+			else if (stmt->func_decl.is_public || is_main) {
+				emit_raw("global %s\n", func_symbol(stmt));
+			}
+		}
+		else if (stmt->type == S_VAR_DECL) {
+			emit_raw("%s $%s\n",
+					 stmt->var_decl.is_variable ? "global" : "extern",
+					 stmt->var_decl.identifier->lexeme);
+		}
+	}
+
+	emit_raw("\nsection .text\n");
+	buf_loop(unit->functions, f) {
+		ProfileMark mark = profile_stmt_begin();
+		gen_function(&unit->functions[f]);
+		profile_stmt_end(mark, PHASE_CODE_GEN, unit->functions[f].decl);
+	}
+
+	gen_globals();
+	gen_strings();
+	emit_raw("\nsection .note.GNU-stack noalloc noexec nowrite progbits\n");
+
+	for (u64 i = 0; i < layouts.cap; ++i) {
+		if (layouts.keys[i]) {
+			delete (StructLayout*)layouts.vals[i];
+		}
+	}
+	map_free(&structs);
+	map_free(&layouts);
+	map_free(&field_offsets);
+	buf_free(strings);
+
+	if (error_count != 0) {
+		writer_discard(&writer);
+		return ETHER_ERROR;
+	}
+	return writer_commit(&writer);
+}
+
+/* initialized globals go to .data, the rest to .bss, which the loader
+ * zeroes as C does */
+void AsmGenerator::gen_globals() {
+	emit_raw("\nsection .data\n");
+	buf_loop(stmts, s) {
+		Stmt* stmt = stmts[s];
+		if (stmt->type == S_VAR_DECL &&
+			stmt->var_decl.is_variable &&
+			stmt->var_decl.initializer) {
+			gen_global_var_decl(stmt);
+		}
+	}
+
+	emit_raw("\nsection .bss\n");
+	buf_loop(stmts, s) {
+		Stmt* stmt = stmts[s];
+		if (stmt->type == S_VAR_DECL &&
+			stmt->var_decl.is_variable &&
+			!stmt->var_decl.initializer) {
+			DataType* data_type = stmt->var_decl.data_type;
+			emit("alignb %lu", type_align(data_type));
+			emit_label("$%s:", stmt->var_decl.identifier->lexeme);
+			emit("resb %lu", CLAMP_MIN(type_size(data_type), 1));
+		}
+	}
+}
+
+/* nothing runs before main, so an initializer must be a value the
+ * assembler can place */
+void AsmGenerator::gen_global_var_decl(Stmt* stmt) {
+	DataType* data_type = stmt->var_decl.data_type;
+	emit("align %lu, db 0", type_align(data_type));
+	emit_label("$%s:", stmt->var_decl.identifier->lexeme);
+	if (type_is_aggregate(data_type) ||
+		!gen_constant(stmt->var_decl.initializer, type_size(data_type))) {
+		error_expr(stmt->var_decl.initializer,
+				   "the nasm backend needs a constant to initialize a global;");
+	}
+}
+
+bool AsmGenerator::gen_constant(Expr* expr, u64 size) {
+	static const char* directives[4] = { "db", "dw", "dd", "dq" };
+	const char* directive = directives[size_index(size)];
+
+	switch (expr->type) {
+	case E_NUMBER:
+		if (expr->number->type != T_INTEGER) {
+			return false;
+		}
+		/* folded constants of signed types may be negative */
+		if (expr->number->lexeme[0] == '-') {
+			emit("%s %ld", directive, strtoll(expr->number->lexeme, null, 10));
+			return true;
+		}
+		emit("%s %lu", directive, strtoull(expr->number->lexeme, null, 10));
+		return true;
+	case E_CHAR:
+		emit("%s %u", directive, ir_char_value(expr->chr->lexeme));
+		return true;
+	case E_CONSTANT:
+		emit("%s %d", directive, expr->constant->keyword == KW_TRUE ? 1 : 0);
+		return true;
+	case E_STRING:
+		emit("dq %s%lu", STRING_PREFIX, buf_len(strings));
+		buf_push(strings, expr->string->lexeme);
+		return true;
+	case E_UNARY:
+		if (expr->unary.op->type == T_MINUS &&
+			expr->unary.right->type == E_NUMBER &&
+			expr->unary.right->number->type == T_INTEGER) {
+			emit("%s -%lu", directive, strtoull(expr->unary.right->number->lexeme, null, 10));
+			return true;
+		}
+		return false;
+	default:
+		return false;
+	}
+}
+
+/* NASM reads C escapes inside backquotes, and ether's escapes are a
+ * subset of them */
+void AsmGenerator::gen_strings() {
+	if (buf_len(strings) == 0) {
+		return;
+	}
+
+	emit_raw("\nsection .rodata\n");
+	buf_loop(strings, s) {
+		emit_raw("%s%lu:\n\tdb `", STRING_PREFIX, s);
+		for (char* c = strings[s]; *c; ++c) {
+			if (*c == '`') {
+				writer_write_char(&writer, '\\');
+			}
+			writer_write_char(&writer, *c);
+		}
+		emit_raw("`, 0\n");
+	}
+}
+
+/* the frame, from rbp down: the callee-saved registers the function
+ * uses, then its locals, then a slot for every IR register that did
+ * not get a machine register */
+void AsmGenerator::gen_function(IrFunction* _function) {
+	function = _function;
+	Stmt* stmt = function->decl;
+	u64 instr_count = buf_len(function->instrs);
+	u64 reg_count = buf_len(function->reg_types);
+	values = new AsmValue[reg_count + 1]();
+	local_offsets = new u64[buf_len(function->locals) + 1]();
+	clobbers = new u32[instr_count + 1]();
+	saved_regs = 0;
+	float_reported = false;
+	block_label = label_count;
+	label_count += buf_len(function->blocks);
+	return_label = new_label();
+
+	check_function();
+	choose_kinds();
+	compute_liveness();
+	alloc_regs();
+	layout_frame();
+
+	char* symbol = func_symbol(stmt);
+	emit_raw("\n");
+	emit_label("%s:", symbol);
+	emit("push rbp");
+	emit("mov rbp, rsp");
+	u64 saved_size = 0;
+	for (int r = 0; r < ASM_REG_COUNT; ++r) {
+		if (saved_regs & (1 << r)) {
+			emit("push %s", reg_names[r][3]);
+			saved_size += 8;
+		}
+	}
+	/* rsp is 16-byte aligned after the pushes and the frame */
+	u64 locals_size = align_up(frame_size, 16) - saved_size;
+	if (locals_size != 0) {
+		emit("sub rsp, %lu", locals_size);
+	}
+
+	for (u32 p = 0; p < function->param_count && p < ASM_ARG_REG_COUNT; ++p) {
+		u64 size = type_size(function->locals[p].type);
+		emit("mov %s [rbp - %lu], %s",
+			 size_names[size_index(size)],
+			 local_offsets[p],
+			 reg_name(arg_regs[p], size));
+	}
+
+	buf_loop(function->block_order, o) {
+		u32 block = function->block_order[o];
+		u32 next_block = (o + 1 < buf_len(function->block_order) ?
+						  function->block_order[o + 1] :
+						  UINT32_MAX);
+		emit_label(".L%lu:", block_label + block);
+		IrBlock* ir_block = &function->blocks[block];
+		for (u32 i = ir_block->first; i < ir_block->first + ir_block->count; ++i) {
+			gen_instr(i, next_block);
+		}
+	}
+
+	emit_label(".L%lu:", return_label);
+	if (saved_size != 0) {
+		emit("lea rsp, [rbp - %lu]", saved_size);
+	}
+	for (int r = ASM_REG_COUNT - 1; r >= 0; --r) {
+		if (saved_regs & (1 << r)) {
+			emit("pop %s", reg_names[r][3]);
+		}
+	}
+	emit("leave");
+	emit("ret");
+
+	delete[] values;
+	delete[] local_offsets;
+	delete[] clobbers;
+	function = null;
+}
+
+void AsmGenerator::check_function() {
+	Stmt* stmt = function->decl;
+	if (function->param_count > ASM_ARG_REG_COUNT) {
+		error_token(stmt->func_decl.identifier,
+					"the nasm backend passes at most %d arguments;",
+					ASM_ARG_REG_COUNT);
+	}
+	buf_loop(stmt->func_decl.params, p) {
+		DataType* data_type = stmt->func_decl.params[p]->var_decl.data_type;
+		if (!data_type->is_array && type_is_aggregate(data_type)) {
+			error_data_type(data_type,
+							"the nasm backend cannot pass a struct by value;");
+		}
+	}
+	if (type_is_aggregate(stmt->func_decl.return_data_type)) {
+		error_data_type(stmt->func_decl.return_data_type,
+						"the nasm backend cannot return a struct by value;");
+	}
+}
+
+/* users come after the instruction defining a value, so walking
+ * backwards settles how a value is used before it is looked at */
+void AsmGenerator::choose_kinds() {
+	u32 instr_count = buf_len(function->instrs);
+	for (u32 pos = 0; pos < instr_count; ++pos) {
+		IrInstr* instr = &function->instrs[pos];
+		if (instr->dst != IR_NO_REG) {
+			values[instr->dst].def = pos;
+			values[instr->dst].mem_only = true;
+		}
+		u32 operands[2] = { instr->a, instr->b };
+		for (u32 o = 0; o < 2; ++o) {
+			if (operands[o] != IR_NO_REG) {
+				values[operands[o]].use_count++;
+				values[operands[o]].user = pos;
+			}
+		}
+		if (instr->op == IR_CALL) {
+			for (u32 a = 0; a < instr->call.arg_count; ++a) {
+				u32 arg = function->args[instr->call.arg_start + a];
+				values[arg].use_count++;
+				values[arg].user = pos;
+			}
+		}
+	}
+
+	for (u32 pos = instr_count; pos > 0; --pos) {
+		IrInstr* instr = &function->instrs[pos - 1];
+		if (instr->dst != IR_NO_REG) {
+			choose_kind(pos - 1);
+		}
+		if (instr->a != IR_NO_REG) {
+			note_use(instr, instr->a);
+		}
+		if (instr->b != IR_NO_REG) {
+			note_use(instr, instr->b);
+		}
+		if (instr->op == IR_CALL) {
+			for (u32 a = 0; a < instr->call.arg_count; ++a) {
+				note_use(instr, function->args[instr->call.arg_start + a]);
+			}
+		}
+	}
+}
+
+void AsmGenerator::choose_kind(u32 pos) {
+	IrInstr* instr = &function->instrs[pos];
+	AsmValue* value = &values[instr->dst];
+	value->kind = ASM_VALUE_REG;
+	if (value->use_count == 0) {
+		value->kind = ASM_VALUE_UNUSED;
+		return;
+	}
+
+	switch (instr->op) {
+	case IR_CONST:
+		if (is_imm_operand(instr->dst)) {
+			value->kind = ASM_VALUE_IMM;
+		}
+		break;
+	case IR_LOCAL:
+	case IR_FIELD:
+		if (value->mem_only && value->index_below <= 1) {
+			value->kind = ASM_VALUE_ADDRESS;
+		}
+		break;
+	case IR_GLOBAL:
+		/* rip-relative operands take no index, and a global of
+		 * another unit is reached through the GOT */
+		if (value->mem_only && value->index_below == 0 &&
+			instr->stmt->var_decl.is_variable) {
+			value->kind = ASM_VALUE_ADDRESS;
+		}
+		break;
+	case IR_INDEX: {
+		if (!value->mem_only) {
+			break;
+		}
+		u64 size = type_size(instr->type);
+		if (is_imm_operand(instr->b)) {
+			if (value->index_below <= 1) {
+				value->kind = ASM_VALUE_ADDRESS;
+			}
+		}
+		else if ((size == 1 || size == 2 || size == 4 || size == 8) &&
+				 value->index_below == 0) {
+			value->kind = ASM_VALUE_ADDRESS;
+		}
+	} break;
+	case IR_EQ:
+	case IR_NE:
+	case IR_LT:
+	case IR_LE:
+	case IR_GT:
+	case IR_GE:
+		if (value->use_count == 1 && value->user == pos + 1 &&
+			function->instrs[pos + 1].op == IR_BRANCH) {
+			value->kind = ASM_VALUE_FLAGS;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void AsmGenerator::note_use(IrInstr* instr, u32 reg) {
+	AsmValue* value = &values[reg];
+	if ((instr->op == IR_LOAD || instr->op == IR_STORE) && reg == instr->a) {
+		return;
+	}
+	if ((instr->op == IR_FIELD || instr->op == IR_INDEX) && reg == instr->a &&
+		values[instr->dst].kind == ASM_VALUE_ADDRESS) {
+		u32 index_below = values[instr->dst].index_below;
+		if (instr->op == IR_INDEX && !is_imm_operand(instr->b)) {
+			index_below++;
+		}
+		value->index_below = MAX(value->index_below, index_below);
+		return;
+	}
+	value->mem_only = false;
+}
+
+/* the immediates an instruction takes in place of the register
+ * operand reg; they sign-extend from 32 bits */
+bool AsmGenerator::can_take_imm(IrInstr* instr, u32 reg, u64 imm) {
+	switch (instr->op) {
+	case IR_ADD:
+	case IR_SUB:
+	case IR_MUL:
+	case IR_AND:
+	case IR_OR:
+	case IR_EQ:
+	case IR_NE:
+	case IR_LT:
+	case IR_LE:
+	case IR_GT:
+	case IR_GE:
+	case IR_STORE:
+		return reg == instr->b && imm <= INT32_MAX;
+	case IR_SHL:
+	case IR_SHR:
+		return reg == instr->b && imm < 64;
+	case IR_INDEX:
+		return reg == instr->b && imm <= INT32_MAX / CLAMP_MIN(type_size(instr->type), 1);
+	case IR_CALL:
+	case IR_RET:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool AsmGenerator::is_imm_operand(u32 reg) {
+	AsmValue* value = &values[reg];
+	IrInstr* def = &function->instrs[value->def];
+	return (def->op == IR_CONST &&
+			!type_is_float(def->type) &&
+			value->use_count == 1 &&
+			can_take_imm(&function->instrs[value->user], reg, def->imm));
+}
+
+/* a folded address reads its base and index where it is used.
+ * registers only flow forward within a statement, so a value is live
+ * from its definition to its last use in layout order */
+void AsmGenerator::compute_liveness() {
+	u32 instr_count = buf_len(function->instrs);
+	for (u32 pos = 0; pos < instr_count; ++pos) {
+		IrInstr* instr = &function->instrs[pos];
+		clobbers[pos + 1] = clobbers[pos];
+		if (instr->op == IR_CALL || instr->op == IR_COPY) {
+			clobbers[pos + 1]++;
+		}
+
+		if (instr->dst != IR_NO_REG) {
+			AsmValueKind kind = values[instr->dst].kind;
+			values[instr->dst].last_use = pos;
+			if (kind == ASM_VALUE_IMM || kind == ASM_VALUE_ADDRESS ||
+				(kind == ASM_VALUE_UNUSED && instr->op != IR_CALL)) {
+				continue;
+			}
+		}
+		if (instr->a != IR_NO_REG) {
+			mark_use(instr->a, pos);
+		}
+		if (instr->b != IR_NO_REG) {
+			mark_use(instr->b, pos);
+		}
+		if (instr->op == IR_CALL) {
+			for (u32 a = 0; a < instr->call.arg_count; ++a) {
+				mark_use(function->args[instr->call.arg_start + a], pos);
+			}
+		}
+	}
+}
+
+void AsmGenerator::mark_use(u32 reg, u32 pos) {
+	AsmValue* value = &values[reg];
+	if (value->kind == ASM_VALUE_ADDRESS) {
+		IrInstr* def = &function->instrs[value->def];
+		if (def->op == IR_FIELD || def->op == IR_INDEX) {
+			mark_use(def->a, pos);
+		}
+		if (def->op == IR_INDEX && values[def->b].kind != ASM_VALUE_IMM) {
+			mark_use(def->b, pos);
+		}
+		return;
+	}
+	value->last_use = MAX(value->last_use, pos);
+}
+
+/* a register is free again only after the instruction of its last
+ * use, so a result never shares one with an operand. a value live
+ * across a call or a copy needs a callee-saved register */
+void AsmGenerator::alloc_regs() {
+	u32 owners[ASM_REG_COUNT];
+	for (int r = 0; r < ASM_REG_COUNT; ++r) {
+		owners[r] = IR_NO_REG;
+	}
+
+	buf_loop(function->instrs, pos) {
+		u32 dst = function->instrs[pos].dst;
+		if (dst == IR_NO_REG || values[dst].kind != ASM_VALUE_REG) {
+			continue;
+		}
+		for (int r = 0; r < ASM_REG_COUNT; ++r) {
+			if (owners[r] != IR_NO_REG && values[owners[r]].last_use < pos) {
+				owners[r] = IR_NO_REG;
+			}
+		}
+
+		AsmValue* value = &values[dst];
+		bool crosses_clobber = clobbers[value->last_use + 1] != clobbers[pos + 1];
+		value->reg = ASM_NO_REG;
+		if (!crosses_clobber) {
+			for (u64 r = 0; r < CALLER_SAVED_COUNT; ++r) {
+				if (owners[caller_saved_regs[r]] == IR_NO_REG) {
+					value->reg = caller_saved_regs[r];
+					break;
+				}
+			}
+		}
+		if (value->reg == ASM_NO_REG) {
+			for (u64 r = 0; r < CALLEE_SAVED_COUNT; ++r) {
+				if (owners[callee_saved_regs[r]] == IR_NO_REG) {
+					value->reg = callee_saved_regs[r];
+					saved_regs |= (1 << value->reg);
+					break;
+				}
+			}
+		}
+		if (value->reg == ASM_NO_REG) {
+			value->kind = ASM_VALUE_SLOT;
+			continue;
+		}
+		owners[value->reg] = dst;
+	}
+}
+
+void AsmGenerator::layout_frame() {
+	frame_size = 0;
+	for (int r = 0; r < ASM_REG_COUNT; ++r) {
+		if (saved_regs & (1 << r)) {
+			frame_size += 8;
+		}
+	}
+	buf_loop(function->locals, l) {
+		DataType* data_type = function->locals[l].type;
+		frame_size = align_up(frame_size + CLAMP_MIN(type_size(data_type), 1),
+							  type_align(data_type));
+		local_offsets[l] = frame_size;
+	}
+	buf_loop(function->reg_types, r) {
+		if (values[r].kind == ASM_VALUE_SLOT) {
+			frame_size = align_up(frame_size + 8, 8);
+			values[r].offset = frame_size;
+		}
+	}
+}
+
+void AsmGenerator::gen_instr(u32 pos, u32 next_block) {
+	IrInstr* instr = &function->instrs[pos];
+	if (!float_reported &&
+		((instr->type && type_is_float(instr->type)) ||
+		 (instr->dst != IR_NO_REG && type_is_float(function->reg_types[instr->dst])))) {
+		error_token(instr->token, "the nasm backend does not support floating-point values;");
+		float_reported = true;
+	}
+	if (instr->dst != IR_NO_REG && instr->op != IR_CALL) {
+		AsmValueKind kind = values[instr->dst].kind;
+		if (kind == ASM_VALUE_IMM || kind == ASM_VALUE_ADDRESS || kind == ASM_VALUE_UNUSED) {
+			return;
+		}
+	}
+
+	switch (instr->op) {
+	case IR_CONST: {
+		int dst = dst_reg(instr->dst);
+		if (instr->imm == 0) {
+			emit("xor %s, %s", reg_name(dst, 4), reg_name(dst, 4));
+		}
+		else if (instr->imm <= UINT32_MAX) {
+			emit("mov %s, %lu", reg_name(dst, 4), instr->imm);
+		}
+		else {
+			emit("mov %s, %lu", reg_name(dst, 8), instr->imm);
+		}
+		finish_dst(instr->dst, dst);
+	} break;
+	case IR_STRING: {
+		int dst = dst_reg(instr->dst);
+		emit("lea %s, [rel %s%lu]", reg_name(dst, 8), STRING_PREFIX, buf_len(strings));
+		buf_push(strings, instr->str);
+		finish_dst(instr->dst, dst);
+	} break;
+	case IR_GLOBAL:
+		/* a global of another unit may be in a shared object */
+		if (!instr->stmt->var_decl.is_variable) {
+			int dst = dst_reg(instr->dst);
+			emit("mov %s, [rel $%s wrt ..gotpcrel]", reg_name(dst, 8),
+				 instr->stmt->var_decl.identifier->lexeme);
+			finish_dst(instr->dst, dst);
+			break;
+		}
+		/* fallthrough */
+	case IR_LOCAL:
+	case IR_FIELD:
+	case IR_INDEX: {
+		int dst = dst_reg(instr->dst);
+		u64 size = type_size(instr->type);
+		if (instr->op == IR_INDEX && !is_imm_operand(instr->b) &&
+			size != 1 && size != 2 && size != 4 && size != 8) {
+			emit("imul %s, %s, %lu", reg_name(dst, 8), value_operand(instr->b), size);
+			emit("add %s, %s", reg_name(dst, 8), value_operand(instr->a));
+		}
+		else {
+			AsmAddress address;
+			compose_address(instr, &address);
+			emit("lea %s, %s", reg_name(dst, 8), address_operand(&address));
+		}
+		finish_dst(instr->dst, dst);
+	} break;
+	case IR_LOAD: {
+		int dst = dst_reg(instr->dst);
+		gen_load(dst, mem_operand(instr->a), instr->type);
+		finish_dst(instr->dst, dst);
+	} break;
+	case IR_STORE: {
+		u64 size = type_size(instr->type);
+		if (values[instr->b].kind == ASM_VALUE_IMM) {
+			emit("mov %s %s, %s", size_names[size_index(size)],
+				 mem_operand(instr->a), value_operand(instr->b));
+		}
+		else {
+			int value = value_in_reg(instr->b, ASM_RCX);
+			emit("mov %s %s, %s", size_names[size_index(size)],
+				 mem_operand(instr->a), reg_name(value, size));
+		}
+	} break;
+	case IR_COPY:
+		emit("mov rdi, %s", value_operand(instr->a));
+		emit("mov rsi, %s", value_operand(instr->b));
+		emit("mov ecx, %lu", type_size(instr->type));
+		emit("rep movsb");
+		break;
+	case IR_ADD:
+	case IR_SUB:
+	case IR_MUL:
+	case IR_DIV:
+	case IR_MOD:
+	case IR_AND:
+	case IR_OR:
+	case IR_SHL:
+	case IR_SHR:
+		gen_binary(instr);
+		break;
+	case IR_EQ:
+	case IR_NE:
+	case IR_LT:
+	case IR_LE:
+	case IR_GT:
+	case IR_GE:
+		gen_compare(instr);
+		break;
+	case IR_NEG:
+	case IR_NOT: {
+		int dst = dst_reg(instr->dst);
+		emit("mov %s, %s", reg_name(dst, 8), value_operand(instr->a));
+		emit("%s %s", instr->op == IR_NEG ? "neg" : "not", reg_name(dst, 8));
+		gen_normalize(dst, instr->type);
+		finish_dst(instr->dst, dst);
+	} break;
+	case IR_LNOT: {
+		int dst = dst_reg(instr->dst);
+		emit("mov %s, %s", reg_name(dst, 8), value_operand(instr->a));
+		emit("xor %s, 1", reg_name(dst, 4));
+		finish_dst(instr->dst, dst);
+	} break;
+	case IR_CAST: {
+		int dst = dst_reg(instr->dst);
+		if (instr->type == data_types.t_bool) {
+			emit("cmp %s, 0", value_operand(instr->a));
+			emit("setne %s", reg_name(dst, 1));
+			emit("movzx %s, %s", reg_name(dst, 4), reg_name(dst, 1));
+		}
+		else {
+			emit("mov %s, %s", reg_name(dst, 8), value_operand(instr->a));
+			gen_normalize(dst, instr->type);
+		}
+		finish_dst(instr->dst, dst);
+	} break;
+	case IR_CALL:
+		gen_call(instr);
+		break;
+	case IR_JUMP:
+		if (instr->target.then_block != next_block) {
+			emit("jmp .L%lu", block_label + instr->target.then_block);
+		}
+		break;
+	case IR_BRANCH:
+		gen_branch(instr, next_block);
+		break;
+	case IR_RET:
+		gen_return(instr, pos);
+		break;
+	case _IR_OP_COUNT:
+		assert(0);
+		break;
+	}
+}
+
+void AsmGenerator::gen_binary(IrInstr* instr) {
+	bool is_signed = type_is_signed(instr->type);
+	int dst = dst_reg(instr->dst);
+	const char* d = reg_name(dst, 8);
+
+	switch (instr->op) {
+	case IR_DIV:
+	case IR_MOD:
+		emit("mov rax, %s", value_operand(instr->a));
+		if (is_signed) {
+			emit("cqo");
+			emit("idiv %s", value_operand(instr->b));
+		}
+		else {
+			emit("xor edx, edx");
+			emit("div %s", value_operand(instr->b));
+		}
+		if (instr->op == IR_MOD || dst != ASM_RAX) {
+			emit("mov %s, %s", d, instr->op == IR_DIV ? "rax" : "rdx");
+		}
+		gen_normalize(dst, instr->type);
+		break;
+	case IR_SHL:
+	case IR_SHR: {
+		const char* shift = (instr->op == IR_SHL ? "shl" : (is_signed ? "sar" : "shr"));
+		emit("mov %s, %s", d, value_operand(instr->a));
+		if (values[instr->b].kind == ASM_VALUE_IMM) {
+			emit("%s %s, %s", shift, d, value_operand(instr->b));
+		}
+		else {
+			emit("mov rcx, %s", value_operand(instr->b));
+			emit("%s %s, cl", shift, d);
+		}
+		/* the value is already extended to 64 bits, so a 64-bit right
+		 * shift gives the narrow result */
+		if (instr->op == IR_SHL) {
+			gen_normalize(dst, instr->type);
+		}
+	} break;
+	default: {
+		const char* op = null;
+		switch (instr->op) {
+		case IR_ADD: op = "add"; break;
+		case IR_SUB: op = "sub"; break;
+		case IR_MUL: op = "imul"; break;
+		case IR_AND: op = "and"; break;
+		case IR_OR: op = "or"; break;
+		default: assert(0); break;
+		}
+		emit("mov %s, %s", d, value_operand(instr->a));
+		if (instr->op == IR_MUL && values[instr->b].kind == ASM_VALUE_IMM) {
+			emit("imul %s, %s, %s", d, d, value_operand(instr->b));
+		}
+		else {
+			emit("%s %s, %s", op, d, value_operand(instr->b));
+		}
+		if (instr->op != IR_AND && instr->op != IR_OR) {
+			gen_normalize(dst, instr->type);
+		}
+	} break;
+	}
+	finish_dst(instr->dst, dst);
+}
+
+/* a comparison the branch reads from the flags ends at the cmp */
+void AsmGenerator::gen_compare(IrInstr* instr) {
+	int left = value_in_reg(instr->a, ASM_RAX);
+	emit("cmp %s, %s", reg_name(left, 8), value_operand(instr->b));
+	if (values[instr->dst].kind == ASM_VALUE_FLAGS) {
+		return;
+	}
+
+	int dst = dst_reg(instr->dst);
+	emit("set%s %s", cond_code(instr->op, type_is_signed(instr->type), false), reg_name(dst, 1));
+	emit("movzx %s, %s", reg_name(dst, 4), reg_name(dst, 1));
+	finish_dst(instr->dst, dst);
+}
+
+/* arguments live in callee-saved registers, the frame or immediates
+ * across the call, so they move to the argument registers in any
+ * order */
+void AsmGenerator::gen_call(IrInstr* instr) {
+	Stmt* called = instr->call.function;
+	if (instr->call.arg_count > ASM_ARG_REG_COUNT) {
+		error_token(instr->token, "the nasm backend passes at most %d arguments;", ASM_ARG_REG_COUNT);
+		return;
+	}
+	buf_loop(called->func_decl.params, p) {
+		DataType* data_type = called->func_decl.params[p]->var_decl.data_type;
+		if (!data_type->is_array && type_is_aggregate(data_type)) {
+			error_token(instr->token, "the nasm backend cannot pass a struct by value;");
+		}
+	}
+	for (u32 a = 0; a < instr->call.arg_count; ++a) {
+		u32 arg = function->args[instr->call.arg_start + a];
+		emit("mov %s, %s", reg_names[arg_regs[a]][3], value_operand(arg));
+	}
+
+	/* al bounds the vector registers a variadic callee reads */
+	emit("xor eax, eax");
+	/* a function of another unit may be in a shared object */
+	if (is_local_function(called)) {
+		emit("call %s", func_symbol(called));
+	}
+	else {
+		emit("call %s wrt ..plt", func_symbol(called));
+	}
+
+	if (instr->dst == IR_NO_REG || values[instr->dst].kind == ASM_VALUE_UNUSED) {
+		return;
+	}
+	DataType* return_type = instr->type;
+	int dst = dst_reg(instr->dst);
+	u64 size = type_size(return_type);
+	if (size == 8) {
+		if (dst != ASM_RAX) {
+			emit("mov %s, rax", reg_name(dst, 8));
+		}
+	}
+	else if (size == 4) {
+		if (type_is_signed(return_type)) {
+			emit("movsxd %s, eax", reg_name(dst, 8));
+		}
+		else {
+			emit("mov %s, eax", reg_name(dst, 4));
+		}
+	}
+	else {
+		emit("%s %s, %s",
+			 type_is_signed(return_type) ? "movsx" : "movzx",
+			 reg_name(dst, type_is_signed(return_type) ? 8 : 4),
+			 reg_name(ASM_RAX, size));
+	}
+	finish_dst(instr->dst, dst);
+}
+
+/* no jump is needed to the block laid out next */
+void AsmGenerator::gen_branch(IrInstr* instr, u32 next_block) {
+	u32 then_block = instr->target.then_block;
+	u32 else_block = instr->target.else_block;
+	IrOp op = IR_NE;
+	bool is_signed = false;
+	if (values[instr->a].kind == ASM_VALUE_FLAGS) {
+		IrInstr* compare = &function->instrs[values[instr->a].def];
+		op = compare->op;
+		is_signed = type_is_signed(compare->type);
+	}
+	else if (values[instr->a].kind == ASM_VALUE_REG) {
+		emit("test %s, %s", reg_name(values[instr->a].reg, 8), reg_name(values[instr->a].reg, 8));
+	}
+	else {
+		emit("cmp %s, 0", value_operand(instr->a));
+	}
+
+	if (then_block == next_block) {
+		emit("j%s .L%lu", cond_code(op, is_signed, true), block_label + else_block);
+		return;
+	}
+	emit("j%s .L%lu", cond_code(op, is_signed, false), block_label + then_block);
+	if (else_block != next_block) {
+		emit("jmp .L%lu", block_label + else_block);
+	}
+}
+
+void AsmGenerator::gen_return(IrInstr* instr, u32 pos) {
+	Stmt* stmt = function->decl;
+	if (instr->a != IR_NO_REG) {
+		emit("mov rax, %s", value_operand(instr->a));
+	}
+	else if (!stmt->func_decl.struct_in &&
+			 stmt->func_decl.identifier->lexeme == names.main) {
+		emit("xor eax, eax");
+	}
+	if (pos + 1 != buf_len(function->instrs)) {
+		emit("jmp .L%lu", return_label);
+	}
+}
+
+/* a register, frame or immediate operand holding the value */
+const char* AsmGenerator::value_operand(u32 reg) {
+	AsmValue* value = &values[reg];
+	char* str = next_operand_buf();
+	switch (value->kind) {
+	case ASM_VALUE_REG:
+		return reg_names[value->reg][3];
+	case ASM_VALUE_SLOT:
+		snprintf(str, sizeof(operand_bufs[0]), "qword [rbp - %lu]", value->offset);
+		return str;
+	case ASM_VALUE_IMM:
+		snprintf(str, sizeof(operand_bufs[0]), "%lu", function->instrs[value->def].imm);
+		return str;
+	default:
+		assert(0);
+		return null;
+	}
+}
+
+int AsmGenerator::value_in_reg(u32 reg, int scratch) {
+	if (values[reg].kind == ASM_VALUE_REG) {
+		return values[reg].reg;
+	}
+	emit("mov %s, %s", reg_name(scratch, 8), value_operand(reg));
+	return scratch;
+}
+
+/* the register to compute a value in; finish_dst moves it to the
+ * frame when the value lives there */
+int AsmGenerator::dst_reg(u32 reg) {
+	if (values[reg].kind == ASM_VALUE_REG) {
+		return values[reg].reg;
+	}
+	return ASM_RAX;
+}
+
+void AsmGenerator::finish_dst(u32 reg, int machine_reg) {
+	if (values[reg].kind == ASM_VALUE_SLOT) {
+		emit("mov qword [rbp - %lu], %s", values[reg].offset, reg_name(machine_reg, 8));
+	}
+}
+
+/* the address LOCAL, GLOBAL, FIELD or INDEX computes. bases come in
+ * rax and indexes in rdx when they live in the frame */
+void AsmGenerator::compose_address(IrInstr* instr, AsmAddress* address) {
+	switch (instr->op) {
+	case IR_LOCAL:
+		address->symbol = null;
+		address->base = ASM_RBP;
+		address->index = ASM_NO_REG;
+		address->scale = 1;
+		address->disp = -(i64)local_offsets[instr->imm];
+		break;
+	case IR_GLOBAL:
+		address->symbol = instr->stmt->var_decl.identifier->lexeme;
+		address->base = ASM_NO_REG;
+		address->index = ASM_NO_REG;
+		address->scale = 1;
+		address->disp = 0;
+		break;
+	case IR_FIELD:
+		compose_value_address(instr->a, address);
+		address->disp += field_offset(instr->stmt, function->reg_types[instr->a]);
+		break;
+	case IR_INDEX: {
+		u64 size = type_size(instr->type);
+		compose_value_address(instr->a, address);
+		if (values[instr->b].kind == ASM_VALUE_IMM) {
+			address->disp += function->instrs[values[instr->b].def].imm * size;
+		}
+		else {
+			assert(address->index == ASM_NO_REG && !address->symbol);
+			address->index = value_in_reg(instr->b, ASM_RDX);
+			address->scale = size;
+		}
+	} break;
+	default:
+		assert(0);
+		break;
+	}
+}
+
+void AsmGenerator::compose_value_address(u32 reg, AsmAddress* address) {
+	if (values[reg].kind == ASM_VALUE_ADDRESS) {
+		compose_address(&function->instrs[values[reg].def], address);
+		return;
+	}
+	address->symbol = null;
+	address->base = value_in_reg(reg, ASM_RAX);
+	address->index = ASM_NO_REG;
+	address->scale = 1;
+	address->disp = 0;
+}
+
+const char* AsmGenerator::address_operand(AsmAddress* address) {
+	char* str = next_operand_buf();
+	u64 size = sizeof(operand_bufs[0]);
+	int len;
+	if (address->symbol) {
+		len = snprintf(str, size, "[rel $%s", address->symbol);
+	}
+	else {
+		len = snprintf(str, size, "[%s", reg_name(address->base, 8));
+		if (address->index != ASM_NO_REG) {
+			len += snprintf(str + len, size - len, " + %s * %lu",
+							reg_name(address->index, 8), address->scale);
+		}
+	}
+	if (address->disp > 0) {
+		len += snprintf(str + len, size - len, " + %ld", address->disp);
+	}
+	else if (address->disp < 0) {
+		len += snprintf(str + len, size - len, " - %ld", -address->disp);
+	}
+	snprintf(str + len, size - len, "]");
+	return str;
+}
+
+/* the memory operand at the address in reg */
+const char* AsmGenerator::mem_operand(u32 reg) {
+	AsmAddress address;
+	compose_value_address(reg, &address);
+	return address_operand(&address);
+}
+
+char* AsmGenerator::next_operand_buf() {
+	operand_buf = (operand_buf + 1) % ASM_OPERAND_BUF_COUNT;
+	return operand_bufs[operand_buf];
+}
+
+const char* AsmGenerator::reg_name(int reg, u64 size) {
+	return reg_names[reg][size_index(size)];
+}
+
+/* every value in a register is extended to 64 bits, as its type
+ * says, so comparisons and division can use the whole register */
+void AsmGenerator::gen_load(int reg, const char* mem, DataType* data_type) {
+	u64 size = type_size(data_type);
+	bool is_signed = type_is_signed(data_type);
+	switch (size) {
+	case 1:
+	case 2:
+		emit("%s %s, %s %s",
+			 is_signed ? "movsx" : "movzx",
+			 reg_name(reg, is_signed ? 8 : 4),
+			 size_names[size_index(size)],
+			 mem);
+		break;
+	case 4:
+		if (is_signed) {
+			emit("movsxd %s, dword %s", reg_name(reg, 8), mem);
+		}
+		else {
+			emit("mov %s, dword %s", reg_name(reg, 4), mem);
+		}
+		break;
+	default:
+		emit("mov %s, qword %s", reg_name(reg, 8), mem);
+		break;
+	}
+}
+
+/* re-extends a value after arithmetic that may have carried past its
+ * type's size */
+void AsmGenerator::gen_normalize(int reg, DataType* data_type) {
+	if (data_type->is_array || data_type->pointer_count != 0) {
+		return;
+	}
+
+	u64 size = type_size(data_type);
+	bool is_signed = type_is_signed(data_type);
+	switch (size) {
+	case 1:
+	case 2:
+		emit("%s %s, %s",
+			 is_signed ? "movsx" : "movzx",
+			 reg_name(reg, is_signed ? 8 : 4),
+			 reg_name(reg, size));
+		break;
+	case 4:
+		if (is_signed) {
+			emit("movsxd %s, %s", reg_name(reg, 8), reg_name(reg, 4));
+		}
+		else {
+			emit("mov %s, %s", reg_name(reg, 4), reg_name(reg, 4));
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* fields are laid out in order, each at its alignment, as C does */
+StructLayout* AsmGenerator::layout_of(Stmt* stmt) {
+	StructLayout* layout = (StructLayout*)map_get(&layouts, stmt);
+	if (layout) {
+		if (layout->in_progress) {
+			error_token(stmt->struct_stmt.identifier,
+						"struct ‘%s’ holds itself by value;",
+						stmt->struct_stmt.identifier->lexeme);
+			layout->in_progress = false;
+		}
+		return layout;
+	}
+
+	layout = new StructLayout;
+	layout->size = 0;
+	layout->align = 1;
+	layout->in_progress = true;
+	map_put(&layouts, stmt, layout);
+
+	Stmt** fields = stmt->struct_stmt.fields;
+	buf_loop(fields, f) {
+		DataType* data_type = fields[f]->var_decl.data_type;
+		u64 align = type_align(data_type);
+		u64 offset = align_up(layout->size, align);
+		map_put_u64_from_u64(&field_offsets, (u64)fields[f], offset + 1);
+		layout->size = offset + type_size(data_type);
+		layout->align = MAX(layout->align, align);
+	}
+	layout->size = align_up(layout->size, layout->align);
+	layout->in_progress = false;
+	return layout;
+}
+
+Stmt* AsmGenerator::struct_of(DataType* data_type) {
+	return (Stmt*)map_get(&structs, data_type->identifier->lexeme);
+}
+
+/* struct_type is the struct, or a pointer to it */
+u64 AsmGenerator::field_offset(Stmt* field, DataType* struct_type) {
+	layout_of(struct_of(struct_type));
+	return map_get_u64_from_u64(&field_offsets, (u64)field) - 1;
+}
+
+u64 AsmGenerator::type_size(DataType* data_type) {
+	if (data_type->is_array) {
+		DataType* elem = data_type_canonical(data_type->identifier->lexeme,
+											 data_type->pointer_count,
+											 false,
+											 null);
+		return type_size(elem) * strtoull(data_type->array_elem_count->lexeme, null, 10);
+	}
+	if (data_type->pointer_count != 0) {
+		return 8;
+	}
+
+	DataType* canonical = data_type->canonical;
+	if (canonical == data_types.t_char ||
+		canonical == data_types.t_bool ||
+		canonical == data_types.t_u8 ||
+		canonical == data_types.t_i8) {
+		return 1;
+	}
+	if (canonical == data_types.t_u16 ||
+		canonical == data_types.t_i16) {
+		return 2;
+	}
+	if (canonical == data_types.t_int ||
+		canonical == data_types.t_uint ||
+		canonical == data_types.t_u32 ||
+		canonical == data_types.t_i32 ||
+		canonical == data_types.t_f32) {
+		return 4;
+	}
+	if (canonical == data_types.t_void) {
+		return 0;
+	}
+
+	Stmt* stmt = struct_of(data_type);
+	if (stmt) {
+		return layout_of(stmt)->size;
+	}
+	return 8;
+}
+
+u64 AsmGenerator::type_align(DataType* data_type) {
+	if (data_type->pointer_count != 0) {
+		return 8;
+	}
+
+	Stmt* stmt = struct_of(data_type);
+	if (stmt) {
+		return layout_of(stmt)->align;
+	}
+	if (data_type->is_array) {
+		data_type = data_type_canonical(data_type->identifier->lexeme, 0, false, null);
+	}
+	return CLAMP_MIN(type_size(data_type), 1);
+}
+
+/* char is signed, as it is for C on x86-64 */
+bool AsmGenerator::type_is_signed(DataType* data_type) {
+	if (data_type->is_array || data_type->pointer_count != 0) {
+		return false;
+	}
+
+	DataType* canonical = data_type->canonical;
+	return (canonical == data_types.t_int ||
+			canonical == data_types.t_i8 ||
+			canonical == data_types.t_i16 ||
+			canonical == data_types.t_i32 ||
+			canonical == data_types.t_i64 ||
+			canonical == data_types.t_char);
+}
+
+bool AsmGenerator::type_is_float(DataType* data_type) {
+	return (data_type->canonical == data_types.t_f32 ||
+			data_type->canonical == data_types.t_f64);
+}
+
+bool AsmGenerator::type_is_aggregate(DataType* data_type) {
+	if (data_type->is_array) {
+		return true;
+	}
+	return data_type->pointer_count == 0 && struct_of(data_type);
+}
+
+bool AsmGenerator::is_local_function(Stmt* stmt) {
+	return stmt->func_decl.is_function;
+}
+
+/* '$' marks an identifier, so a function may be named like a
+ * register or an instruction */
+char* AsmGenerator::func_symbol(Stmt* stmt) {
+	std::string symbol = "$";
+	if (stmt->func_decl.struct_in) {
+		symbol += stmt->func_decl.struct_in->struct_stmt.identifier->lexeme;
+		symbol += '_';
+	}
+	symbol += stmt->func_decl.identifier->lexeme;
+	return str_intern((char*)symbol.c_str());
+}
+
+u64 AsmGenerator::new_label() {
+	return label_count++;
+}
+
+void AsmGenerator::emit(const char* fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	writer_write_char(&writer, '\t');
+	write_formatted(&writer, fmt, ap);
+	writer_write_char(&writer, '\n');
+	va_end(ap);
+}
+
+void AsmGenerator::emit_label(const char* fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	write_formatted(&writer, fmt, ap);
+	writer_write_char(&writer, '\n');
+	va_end(ap);
+}
+
+void AsmGenerator::emit_raw(const char* fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	write_formatted(&writer, fmt, ap);
+	va_end(ap);
+}
+
+void AsmGenerator::error_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
+	print_error_at(
+		srcfile,
+		offset,
+		char_count,
+		fmt,
+		ap);
+	error_count++;
+}
+
+void AsmGenerator::warning_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
+	print_warning_at(
+		srcfile,
+		offset,
+		char_count,
+		fmt,
+		ap);
+}
+
+error_code run_assembler(char* asm_fpath, char* obj_fpath) {
+	char* argv[] = {
+		ASSEMBLER,
+		"-felf64",
+		"-o",
+		obj_fpath,
+		asm_fpath,
+		null,
+	};
+	return run_program(argv);
+}
@@ -0,0 +1,39 @@
+#include <ether.hpp>
+#include <ast_arena.hpp>
+
+static const char* ast_node_kind_names[_AST_NODE_KIND_COUNT] = {
+	"stmt",
+	"expr",
+	"data type",
+	"token",
+	"if branch",
+	"switch branch",
+};
+
+void* ast_alloc(AstArena* ast_arena, AstNodeKind kind, u64 size) {
+	void* node = arena_alloc(&ast_arena->arena, size);
+	memset(node, 0, size);
+	ast_arena->node_counts[kind]++;
+	ast_arena->node_bytes[kind] += size;
+	return node;
+}
+
+void ast_arena_free(AstArena* ast_arena) {
+	arena_free(&ast_arena->arena);
+	memset(ast_arena->node_counts, 0, sizeof(ast_arena->node_counts));
+	memset(ast_arena->node_bytes, 0, sizeof(ast_arena->node_bytes));
+}
+
+void ast_arena_print_stats(AstArena* ast_arena, const char* fpath) {
+	fprintf(stderr, "%s: %lu nodes, %lu bytes in %lu blocks\n",
+			fpath,
+			ast_arena->arena.alloc_count,
+			ast_arena->arena.bytes_allocated,
+			buf_len(ast_arena->arena.blocks));
+	for (u64 k = 0; k < _AST_NODE_KIND_COUNT; k++) {
+		fprintf(stderr, "  %-14s %10lu nodes %12lu bytes\n",
+				ast_node_kind_names[k],
+				ast_arena->node_counts[k],
+				ast_arena->node_bytes[k]);
+	}
+}
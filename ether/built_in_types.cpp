@@ -1,8 +1,30 @@
 #include <ether.hpp>
 
+/* interned by sys_names_init */
 char* built_in_types[BUILT_IN_TYPES_LEN] = {
 	"int",
 	"char",
 	"bool",
 	"void",
 };
+
+WellKnownNames names;
+
+void sys_names_init() {
+	for (u64 i = 0; i < BUILT_IN_TYPES_LEN; i++) {
+		built_in_types[i] = str_intern(built_in_types[i]);
+	}
+
+	names.main = str_intern("main");
+	names.void_type = str_intern("void");
+	names.eof = str_intern("*EOF*");
+}
+
+bool is_built_in_type(char* lexeme) {
+	for (u64 i = 0; i < BUILT_IN_TYPES_LEN; i++) {
+		if (lexeme == built_in_types[i]) {
+			return true;
+		}
+	}
+	return false;
+}
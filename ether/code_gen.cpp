@@ -3,54 +3,711 @@
 #include <expr.hpp>
 #include <token.hpp>
 #include <data_type.hpp>
+#include <profile.hpp>
+#include <ir.hpp>
 
-void CodeGenerator::generate(Stmt** _stmts, char* _obj_fpath) {
-	printf("Generating %s...\n", _obj_fpath);
+#define REG_PREFIX "_ether_r"
+#define LOCAL_PREFIX "_ether_l"
+#define BLOCK_PREFIX "_ether_b"
+
+error_code CodeGenerator::generate(Stmt** _stmts, IrUnit* _ir, char* _output_fpath) {
 	stmts = _stmts;
-	obj_fpath = _obj_fpath;
-	
-	output_code = null;
+	ir = _ir;
+	output_fpath = _output_fpath;
 	tab_count = 0;
+	structs = {};
+	structs_emitted = {};
+	function = null;
+	block_labeled = null;
+
+	if (writer_open(&writer, output_fpath) == ETHER_ERROR) {
+		return ETHER_ERROR;
+	}
+
+	output_mutex.lock();
+	printf("Generating %s...\n", output_fpath);
+	output_mutex.unlock();
+
+	gen_prelude();
 
 	buf_loop(stmts, s) {
-		gen_stmt(stmts[s]);		
+		Stmt* stmt = stmts[s];
+		if (stmt->type == S_STRUCT &&
+			!map_get(&structs, stmt->struct_stmt.identifier->lexeme)) {
+			map_put(&structs, stmt->struct_stmt.identifier->lexeme, stmt);
+			print_string("typedef struct ");
+			print_token(stmt->struct_stmt.identifier);
+			print_space();
+			print_token(stmt->struct_stmt.identifier);
+			print_semicolon();
+			print_newline();
+		}
 	}
-	buf_push(output_code, '\0');
-	printf("%s", output_code);
-}
+	print_newline();
 
-void CodeGenerator::gen_stmt(Stmt* stmt) {
-	print_tabs_by_indentation();
-	switch (stmt->type) {
-	case S_STRUCT:
-		gen_struct(stmt);
-		break;
-	case S_VAR_DECL:
-		gen_var_decl(stmt);
-		break;
+	buf_loop(stmts, s) {
+		if (stmts[s]->type == S_STRUCT) {
+			gen_struct((Stmt*)map_get(&structs, stmts[s]->struct_stmt.identifier->lexeme));
+		}
+	}
+
+	buf_loop(stmts, s) {
+		if (stmts[s]->type == S_VAR_DECL) {
+			ProfileMark mark = profile_stmt_begin();
+			gen_global_var_decl(stmts[s]);
+			profile_stmt_end(mark, PHASE_CODE_GEN, stmts[s]);
+		}
 	}
 	print_newline();
+
+	buf_loop(stmts, s) {
+		if (stmts[s]->type == S_FUNC_DECL) {
+			gen_func_header(stmts[s]);
+			print_semicolon();
+			print_newline();
+		}
+	}
+	print_newline();
+
+	buf_loop(ir->functions, f) {
+		ProfileMark mark = profile_stmt_begin();
+		gen_function(&ir->functions[f]);
+		profile_stmt_end(mark, PHASE_CODE_GEN, ir->functions[f].decl);
+	}
+
+	map_free(&structs);
+	map_free(&structs_emitted);
+	buf_free(block_labeled);
+	return writer_commit(&writer);
+}
+
+/* names of the built-in types that C does not have */
+void CodeGenerator::gen_prelude() {
+	print_string("#include <stdbool.h>\n"
+				 "#include <stddef.h>\n"
+				 "#include <stdint.h>\n"
+				 "#include <string.h>\n"
+				 "\n"
+				 "typedef unsigned int uint;\n"
+				 "typedef uint8_t u8;\n"
+				 "typedef uint16_t u16;\n"
+				 "typedef uint32_t u32;\n"
+				 "typedef uint64_t u64;\n"
+				 "typedef int8_t i8;\n"
+				 "typedef int16_t i16;\n"
+				 "typedef int32_t i32;\n"
+				 "typedef int64_t i64;\n"
+				 "typedef float f32;\n"
+				 "typedef double f64;\n"
+				 "\n");
 }
 
 void CodeGenerator::gen_struct(Stmt* stmt) {
-	print_string("typedef struct ");
+	if (map_get(&structs_emitted, stmt)) {
+		return;
+	}
+	map_put(&structs_emitted, stmt, stmt);
+
+	Stmt** fields = stmt->struct_stmt.fields;
+	buf_loop(fields, f) {
+		DataType* data_type = fields[f]->var_decl.data_type;
+		if (data_type->pointer_count == 0) {
+			Stmt* field_struct = (Stmt*)map_get(&structs, data_type->identifier->lexeme);
+			if (field_struct) {
+				gen_struct(field_struct);
+			}
+		}
+	}
+
+	print_string("struct ");
 	print_token(stmt->struct_stmt.identifier);
 	print_string(" {");
 	print_newline();
 
 	tab_count++;
-	buf_loop(stmt->struct_stmt.fields, f) {
-		gen_stmt(stmt->struct_stmt.fields[f]);
+	buf_loop(fields, f) {
+		print_tabs_by_indentation();
+		print_var(fields[f]->var_decl.data_type, fields[f]->var_decl.identifier->lexeme);
+		print_semicolon();
+		print_newline();
 	}
 	tab_count--;
-	print_char('}');
+	print_string("};");
+	print_newline();
+	print_newline();
 }
 
-void CodeGenerator::gen_var_decl(Stmt* stmt) {
-	print_data_type(stmt->var_decl.data_type);
+/* a global declared in another unit is only declared here. nothing
+ * runs before main, so an initializer is emitted as a C constant
+ * expression rather than lowered */
+void CodeGenerator::gen_global_var_decl(Stmt* stmt) {
+	if (!stmt->var_decl.is_variable) {
+		print_string("extern ");
+	}
+	print_var(stmt->var_decl.data_type, stmt->var_decl.identifier->lexeme);
+	if (stmt->var_decl.is_variable && stmt->var_decl.initializer) {
+		print_string(" = ");
+		gen_expr(stmt->var_decl.initializer);
+	}
+	print_semicolon();
+	print_newline();
+}
+
+/* functions that are not pub stay in this unit. a struct function
+ * takes its struct by pointer, as ‘this’ */
+void CodeGenerator::gen_func_header(Stmt* stmt) {
+	if (stmt->func_decl.is_function &&
+		!stmt->func_decl.is_public &&
+		!is_main(stmt)) {
+		print_string("static ");
+	}
+
+	if (is_main(stmt) &&
+		data_type_match(stmt->func_decl.return_data_type, data_types.t_void) == DT_MATCH) {
+		print_string("int");
+	}
+	else {
+		print_data_type(stmt->func_decl.return_data_type);
+	}
 	print_space();
-	print_token(stmt->var_decl.identifier);
+	print_func_name(stmt);
+	print_char('(');
+
+	bool first = true;
+	if (stmt->func_decl.struct_in) {
+		print_token(stmt->func_decl.struct_in->struct_stmt.identifier);
+		print_string("* this");
+		first = false;
+	}
+	buf_loop(stmt->func_decl.params, p) {
+		if (!first) {
+			print_string(", ");
+		}
+		print_var(stmt->func_decl.params[p]->var_decl.data_type,
+				  stmt->func_decl.params[p]->var_decl.identifier->lexeme);
+		first = false;
+	}
+	if (first) {
+		print_string("void");
+	}
+	print_char(')');
+}
+
+/* the parameters keep their names; the other locals and every
+ * register are declared up front, so a goto never jumps past a
+ * declaration */
+void CodeGenerator::gen_function(IrFunction* _function) {
+	function = _function;
+	gen_func_header(function->decl);
+	print_string(" {");
+	print_newline();
+	tab_count++;
+
+	for (u32 l = function->param_count; l < buf_len(function->locals); l++) {
+		print_tabs_by_indentation();
+		char name[32];
+		snprintf(name, sizeof(name), LOCAL_PREFIX "%u", l);
+		print_var(function->locals[l].type, name);
+		print_semicolon();
+		print_newline();
+	}
+
+	/* a struct returned by a call is kept in a variable of its own,
+	 * and its register holds the address, as for any aggregate */
+	buf_loop(function->reg_types, r) {
+		DataType* data_type = function->reg_types[r];
+		print_tabs_by_indentation();
+		print_data_type(data_type);
+		if (is_aggregate(data_type)) {
+			print_space();
+			print_string(REG_PREFIX "v");
+			print_u64(r);
+			print_string(", *");
+		}
+		else {
+			print_space();
+		}
+		print_reg((u32)r);
+		print_semicolon();
+		print_newline();
+	}
+
+	buf_clear(block_labeled);
+	buf_loop(function->blocks, b) {
+		buf_push(block_labeled, false);
+	}
+	buf_loop(function->block_order, o) {
+		IrBlock* block = &function->blocks[function->block_order[o]];
+		IrInstr* last = &function->instrs[block->first + block->count - 1];
+		u32 next_block = (o + 1 < buf_len(function->block_order) ?
+						  function->block_order[o + 1] :
+						  IR_NO_REG);
+		if (last->op == IR_BRANCH) {
+			block_labeled[last->target.then_block] = true;
+		}
+		if (last->op == IR_BRANCH && last->target.else_block != next_block) {
+			block_labeled[last->target.else_block] = true;
+		}
+		if (last->op == IR_JUMP && last->target.then_block != next_block) {
+			block_labeled[last->target.then_block] = true;
+		}
+	}
+
+	buf_loop(function->block_order, o) {
+		u32 block = function->block_order[o];
+		u32 next_block = (o + 1 < buf_len(function->block_order) ?
+						  function->block_order[o + 1] :
+						  IR_NO_REG);
+		if (block_labeled[block]) {
+			print_block(block);
+			print_char(':');
+			print_newline();
+		}
+		IrBlock* ir_block = &function->blocks[block];
+		for (u32 i = ir_block->first; i < ir_block->first + ir_block->count; i++) {
+			gen_instr(&function->instrs[i], next_block);
+		}
+	}
+
+	tab_count--;
+	print_char('}');
+	print_newline();
+	print_newline();
+	function = null;
+}
+
+static const char* binary_op(IrOp op) {
+	switch (op) {
+	case IR_ADD: return "+";
+	case IR_SUB: return "-";
+	case IR_MUL: return "*";
+	case IR_DIV: return "/";
+	case IR_MOD: return "%";
+	case IR_AND: return "&";
+	case IR_OR: return "|";
+	case IR_SHL: return "<<";
+	case IR_SHR: return ">>";
+	case IR_EQ: return "==";
+	case IR_NE: return "!=";
+	case IR_LT: return "<";
+	case IR_LE: return "<=";
+	case IR_GT: return ">";
+	case IR_GE: return ">=";
+	default: return null;
+	}
+}
+
+/* a register gets the result in its own type, which truncates the
+ * way the IR defines; an address is cast to the type of its register */
+void CodeGenerator::gen_instr(IrInstr* instr, u32 next_block) {
+	/* the return the lowering adds after the last statement, where
+	 * control only gets without a value in a void function; elsewhere
+	 * it falls off the end as the source does */
+	if (instr->op == IR_RET &&
+		instr->a == IR_NO_REG &&
+		!is_main(function->decl) &&
+		data_type_match(function->decl->func_decl.return_data_type, data_types.t_void) == DT_NOT_MATCH) {
+		return;
+	}
+	if (instr->op == IR_JUMP) {
+		gen_jump(instr->target.then_block, next_block);
+		return;
+	}
+
+	print_tabs_by_indentation();
+	if (instr->dst != IR_NO_REG && instr->op != IR_CALL) {
+		print_reg(instr->dst);
+		print_string(" = ");
+	}
+
+	switch (instr->op) {
+	case IR_CONST: {
+		print_char('(');
+		print_data_type(instr->type);
+		print_char(')');
+		char str[48];
+		if (instr->type == data_types.t_f32 || instr->type == data_types.t_f64) {
+			double value;
+			memcpy(&value, &instr->imm, sizeof(value));
+			snprintf(str, sizeof(str), "%a", value);
+		}
+		else if ((i64)instr->imm >= 0) {
+			snprintf(str, sizeof(str), "%lu", instr->imm);
+		}
+		else if ((i64)instr->imm != INT64_MIN) {
+			snprintf(str, sizeof(str), "-%lu", (u64)-(i64)instr->imm);
+		}
+		else {
+			snprintf(str, sizeof(str), "%luu", instr->imm);
+		}
+		print_string(str);
+	} break;
+
+	case IR_STRING:
+		print_char('"');
+		print_string(instr->str);
+		print_char('"');
+		break;
+
+	case IR_GLOBAL:
+		print_char('(');
+		print_data_type(function->reg_types[instr->dst]);
+		print_string(")&");
+		print_token(instr->stmt->var_decl.identifier);
+		break;
+
+	case IR_LOCAL: {
+		print_char('(');
+		print_data_type(function->reg_types[instr->dst]);
+		print_string(")&");
+		print_local((u32)instr->imm);
+	} break;
+
+	case IR_LOAD:
+		print_string("*(");
+		print_data_type(instr->type);
+		print_string("*)");
+		print_reg(instr->a);
+		break;
+
+	case IR_STORE:
+		print_string("*(");
+		print_data_type(instr->type);
+		print_string("*)");
+		print_reg(instr->a);
+		print_string(" = ");
+		print_reg(instr->b);
+		break;
+
+	case IR_COPY:
+		print_string("memcpy(");
+		print_reg(instr->a);
+		print_string(", ");
+		print_reg(instr->b);
+		print_string(", sizeof(");
+		print_type_name(instr->type);
+		print_string("))");
+		break;
+
+	case IR_FIELD:
+		print_char('(');
+		print_data_type(function->reg_types[instr->dst]);
+		print_string(")&");
+		print_reg(instr->a);
+		print_string("->");
+		print_token(instr->stmt->var_decl.identifier);
+		break;
+
+	case IR_INDEX:
+		print_reg(instr->a);
+		print_string(" + ");
+		print_reg(instr->b);
+		break;
+
+	case IR_ADD:
+	case IR_SUB:
+	case IR_MUL:
+	case IR_DIV:
+	case IR_MOD:
+	case IR_AND:
+	case IR_OR:
+	case IR_SHL:
+	case IR_SHR:
+	case IR_EQ:
+	case IR_NE:
+	case IR_LT:
+	case IR_LE:
+	case IR_GT:
+	case IR_GE:
+		print_reg(instr->a);
+		print_space();
+		print_string((char*)binary_op(instr->op));
+		print_space();
+		print_reg(instr->b);
+		break;
+
+	case IR_NEG:
+		print_char('-');
+		print_reg(instr->a);
+		break;
+
+	case IR_NOT:
+		print_char('~');
+		print_reg(instr->a);
+		break;
+
+	case IR_LNOT:
+		print_char('!');
+		print_reg(instr->a);
+		break;
+
+	case IR_CAST:
+		print_char('(');
+		print_data_type(instr->type);
+		print_char(')');
+		print_reg(instr->a);
+		break;
+
+	case IR_CALL:
+		gen_call(instr);
+		break;
+
+	case IR_BRANCH:
+		print_string("if (");
+		print_reg(instr->a);
+		print_string(") goto ");
+		print_block(instr->target.then_block);
+		print_semicolon();
+		print_newline();
+		gen_jump(instr->target.else_block, next_block);
+		return;
+
+	case IR_RET:
+		print_string("return");
+		if (instr->a != IR_NO_REG) {
+			print_space();
+			if (is_aggregate(instr->type)) {
+				print_char('*');
+			}
+			print_reg(instr->a);
+		}
+		else if (is_main(function->decl)) {
+			print_string(" 0");
+		}
+		break;
+
+	default:
+		assert(0);
+		break;
+	}
+	print_semicolon();
+	print_newline();
+}
+
+void CodeGenerator::gen_jump(u32 block, u32 next_block) {
+	if (block == next_block) {
+		return;
+	}
+	print_tabs_by_indentation();
+	print_string("goto ");
+	print_block(block);
 	print_semicolon();
+	print_newline();
+}
+
+/* a struct argument is passed by value from the address in its
+ * register; ‘this’ and arrays are passed as addresses */
+void CodeGenerator::gen_call(IrInstr* instr) {
+	Stmt* called = instr->call.function;
+	if (instr->dst != IR_NO_REG) {
+		if (is_aggregate(function->reg_types[instr->dst])) {
+			print_string(REG_PREFIX "v");
+			print_u64(instr->dst);
+		}
+		else {
+			print_reg(instr->dst);
+		}
+		print_string(" = ");
+	}
+	print_func_name(called);
+	print_char('(');
+
+	u32 first_param = (called->func_decl.struct_in ? 1 : 0);
+	for (u32 a = 0; a < instr->call.arg_count; a++) {
+		if (a != 0) {
+			print_string(", ");
+		}
+		if (a >= first_param) {
+			DataType* data_type = called->func_decl.params[a - first_param]->var_decl.data_type;
+			if (!data_type->is_array && is_aggregate(data_type)) {
+				print_char('*');
+			}
+		}
+		print_reg(function->args[instr->call.arg_start + a]);
+	}
+	print_char(')');
+
+	if (instr->dst != IR_NO_REG && is_aggregate(function->reg_types[instr->dst])) {
+		print_semicolon();
+		print_space();
+		print_reg(instr->dst);
+		print_string(" = &" REG_PREFIX "v");
+		print_u64(instr->dst);
+	}
+}
+
+void CodeGenerator::gen_expr(Expr* expr) {
+	switch (expr->type) {
+	case E_BINARY:
+		gen_binary_expr(expr);
+		break;
+	case E_UNARY:
+		gen_unary_expr(expr);
+		break;
+	case E_CAST:
+		gen_cast_expr(expr);
+		break;
+	case E_FUNC_CALL:
+		gen_func_call(expr);
+		break;
+	case E_ARRAY_ACCESS:
+		gen_array_access(expr);
+		break;
+	case E_MEMBER_ACCESS:
+		gen_member_access(expr);
+		break;
+	case E_VARIABLE_REF:
+		print_token(expr->variable_ref.identifier);
+		break;
+	case E_NUMBER:
+		gen_number_expr(expr);
+		break;
+	case E_STRING:
+		print_char('"');
+		print_token(expr->string);
+		print_char('"');
+		break;
+	case E_CHAR:
+		print_char('\'');
+		print_token(expr->chr);
+		print_char('\'');
+		break;
+	case E_CONSTANT:
+		gen_constant_expr(expr);
+		break;
+	}
+}
+
+/* every operator means the same in C; the parentheses keep ether's
+ * precedence */
+void CodeGenerator::gen_binary_expr(Expr* expr) {
+	print_char('(');
+	gen_expr(expr->binary.left);
+	print_space();
+	print_token(expr->binary.op);
+	print_space();
+	gen_expr(expr->binary.right);
+	print_char(')');
+}
+
+void CodeGenerator::gen_unary_expr(Expr* expr) {
+	print_char('(');
+	if (expr->unary.op->type == T_CARET) {
+		print_char('*');
+	}
+	else {
+		print_token(expr->unary.op);
+	}
+	gen_expr(expr->unary.right);
+	print_char(')');
+}
+
+void CodeGenerator::gen_cast_expr(Expr* expr) {
+	print_string("((");
+	print_data_type(expr->cast.cast_to);
+	print_char(')');
+	gen_expr(expr->cast.right);
+	print_char(')');
+}
+
+void CodeGenerator::gen_func_call(Expr* expr) {
+	Stmt* called = expr->func_call.function_called;
+	print_func_name(called);
+	print_char('(');
+
+	bool first = true;
+	if (called->func_decl.struct_in) {
+		Expr* object = expr->func_call.left->member_access.left;
+		if (object->data_type->pointer_count == 0) {
+			print_char('&');
+		}
+		gen_expr(object);
+		first = false;
+	}
+	buf_loop(expr->func_call.args, a) {
+		if (!first) {
+			print_string(", ");
+		}
+		gen_expr(expr->func_call.args[a]);
+		first = false;
+	}
+	print_char(')');
+}
+
+void CodeGenerator::gen_array_access(Expr* expr) {
+	gen_expr(expr->array_access.left);
+	print_char('[');
+	gen_expr(expr->array_access.index);
+	print_char(']');
+}
+
+void CodeGenerator::gen_member_access(Expr* expr) {
+	gen_expr(expr->member_access.left);
+	if (expr->member_access.left->data_type->pointer_count == 0) {
+		print_char('.');
+	}
+	else {
+		print_string("->");
+	}
+	print_token(expr->member_access.right);
+}
+
+/* integers are decimal even with leading zeros, which C reads as
+ * octal. an integer of a type other than int comes from constant
+ * folding and is cast to it, as C would give the literal its own type */
+void CodeGenerator::gen_number_expr(Expr* expr) {
+	char* lexeme = expr->number->lexeme;
+	if (expr->number->type != T_INTEGER) {
+		print_string(lexeme);
+		return;
+	}
+
+	while (lexeme[0] == '0' && lexeme[1] != '\0') {
+		lexeme++;
+	}
+	if (expr->data_type->canonical == data_types.t_int) {
+		print_string(lexeme);
+		return;
+	}
+
+	print_string("((");
+	print_data_type(expr->data_type);
+	print_char(')');
+	print_string(lexeme);
+	if (lexeme[0] != '-' && strtoull(lexeme, null, 10) > INT64_MAX) {
+		print_char('u');
+	}
+	print_char(')');
+}
+
+void CodeGenerator::gen_constant_expr(Expr* expr) {
+	switch (expr->constant->keyword) {
+	case KW_TRUE:
+		print_string("true");
+		break;
+	case KW_FALSE:
+		print_string("false");
+		break;
+	case KW_NULL:
+		print_string("NULL");
+		break;
+	default:
+		assert(0);
+		break;
+	}
+}
+
+bool CodeGenerator::is_aggregate(DataType* data_type) {
+	if (data_type->is_array) {
+		return true;
+	}
+	return (data_type->pointer_count == 0 &&
+			map_get(&structs, data_type->identifier->lexeme));
+}
+
+bool CodeGenerator::is_main(Stmt* stmt) {
+	return (!stmt->func_decl.struct_in &&
+			stmt->func_decl.identifier->lexeme == names.main);
 }
 
 void CodeGenerator::print_data_type(DataType* data_type) {
@@ -60,6 +717,67 @@ void CodeGenerator::print_data_type(DataType* data_type) {
 	}
 }
 
+/* a type as sizeof takes it, with an array's size */
+void CodeGenerator::print_type_name(DataType* data_type) {
+	print_data_type(data_type);
+	if (data_type->is_array) {
+		print_char('[');
+		print_token(data_type->array_elem_count);
+		print_char(']');
+	}
+}
+
+/* a declaration, where C puts the array size after the name */
+void CodeGenerator::print_var(DataType* data_type, char* name) {
+	print_data_type(data_type);
+	print_space();
+	print_string(name);
+	if (data_type->is_array) {
+		print_char('[');
+		print_token(data_type->array_elem_count);
+		print_char(']');
+	}
+}
+
+void CodeGenerator::print_func_name(Stmt* stmt) {
+	if (stmt->func_decl.struct_in) {
+		print_token(stmt->func_decl.struct_in->struct_stmt.identifier);
+		print_char('_');
+	}
+	print_token(stmt->func_decl.identifier);
+}
+
+void CodeGenerator::print_reg(u32 reg) {
+	print_string(REG_PREFIX);
+	print_u64(reg);
+}
+
+void CodeGenerator::print_local(u32 local) {
+	if (local < function->param_count) {
+		print_string(function->locals[local].name);
+		return;
+	}
+	print_string(LOCAL_PREFIX);
+	print_u64(local);
+}
+
+void CodeGenerator::print_block(u32 block) {
+	print_string(BLOCK_PREFIX);
+	print_u64(block);
+}
+
+/* register and block numbers are printed for nearly every line, too
+ * often to go through snprintf */
+void CodeGenerator::print_u64(u64 n) {
+	char str[20];
+	u64 len = 0;
+	do {
+		str[sizeof(str) - ++len] = (char)('0' + n % 10);
+		n /= 10;
+	} while (n);
+	writer_write(&writer, str + sizeof(str) - len, len);
+}
+
 void CodeGenerator::print_tabs_by_indentation() {
 	for (u64 i = 0; i < tab_count; ++i) {
 		print_tab_with_spaces();
@@ -89,13 +807,29 @@ void CodeGenerator::print_token(Token* token) {
 }
 
 void CodeGenerator::print_string(char* str) {
-	char* _str = str;
-	while (*_str != '\0') {
-		print_char(*_str);
-		_str++;
-	}
+	writer_write_str(&writer, str);
 }
 
 void CodeGenerator::print_char(char ch) {
-	buf_push(output_code, ch);
+	writer_write_char(&writer, ch);
+}
+
+/* compiles the generated C into an object file with C_COMPILER, or
+ * $CC if it is set */
+error_code run_c_compiler(char* c_fpath, char* obj_fpath) {
+	char* cc = getenv("CC");
+	if (!cc || cc[0] == '\0') {
+		cc = C_COMPILER;
+	}
+
+	char* argv[] = {
+		cc,
+		C_COMPILER_OPT_LEVEL,
+		"-c",
+		c_fpath,
+		"-o",
+		obj_fpath,
+		null,
+	};
+	return run_program(argv);
 }
@@ -3,78 +3,390 @@
 #include <token.hpp>
 #include <lexer.hpp>
 #include <parser.hpp>
+#include <ast_arena.hpp>
 #include <ast_printer.hpp>
 #include <linker.hpp>
 #include <resolve.hpp>
+#include <const_fold.hpp>
 #include <code_gen.hpp>
+#include <asm_gen.hpp>
+#include <ir.hpp>
+#include <ir_printer.hpp>
+#include <ir_parser.hpp>
+#include <math.hpp>
+#include <profile.hpp>
+#include <stats.hpp>
 
-static FileDecl* file_decls = null;
+#include <atomic>
+#include <thread>
 
-Stmt** Compiler::compile(const char* in_file) {
-	std::string current_file = std::string(in_file);
+static CompileUnit** compile_units = null;
+static u64 compile_jobs = 1;
+static Backend compile_backend = BACKEND_C;
 
-	char* obj_fpath = change_extension(current_file, "o");
-	
-	buf_loop(file_decls, f) {
-		if (str_intern(file_decls[f].fpath) ==
-			str_intern(const_cast<char*>(in_file))) {
-			return file_decls[f].decls;
+/* runs work on every unit of the list, on up to compile_jobs threads;
+ * the calling thread is one of them, as worker 0. a traced thread is
+ * named by its worker index, so every wave reuses the same tids */
+static void compile_units_parallel(CompileUnit** list, u64 len, void (*work)(CompileUnit*)) {
+	std::atomic<u64> next(0);
+	auto worker = [&](u64 index) {
+		profile_thread(index);
+		for (;;) {
+			u64 i = next.fetch_add(1);
+			if (i >= len) {
+				break;
+			}
+			work(list[i]);
 		}
+	};
+
+	u64 thread_count = CLAMP_MAX(compile_jobs, len);
+	if (thread_count <= 1) {
+		worker(0);
+		return;
+	}
+	/* set before the first thread starts and cleared after the last is
+	 * joined, so every worker sees it set */
+	threads_running = true;
+	std::thread* threads = new std::thread[thread_count];
+	for (u64 t = 1; t < thread_count; t++) {
+		threads[t] = std::thread(worker, t);
 	}
-	
-	SourceFile* srcfile = read_file(in_file);
+	worker(0);
+	for (u64 t = 1; t < thread_count; t++) {
+		threads[t].join();
+	}
+	delete[] threads;
+	threads_running = false;
+}
+
+static CompileUnit* add_compile_unit(char* fpath, char* canonical_fpath) {
+	buf_loop(compile_units, u) {
+		if (compile_units[u]->canonical_fpath == canonical_fpath) {
+			return compile_units[u];
+		}
+	}
+
+	CompileUnit* unit = new CompileUnit();
+	unit->fpath = fpath;
+	unit->canonical_fpath = canonical_fpath;
+	unit->profile = profile_file(fpath);
+	buf_push(compile_units, unit);
+	return unit;
+}
+
+static void parse_unit(CompileUnit* unit) {
+	ProfileMark unit_mark = profile_begin();
+	ProfileMark mark = profile_begin();
+	SourceFile* srcfile = read_file(unit->fpath);
 	if (!srcfile) {
-		ether_abort("%s: no such file or directory", in_file);
-		return null; /* unreachable */
+		ether_abort("%s: no such file or directory", unit->fpath);
+		return; /* unreachable */
 	}
+	unit->srcfile = srcfile;
+	profile_end(mark, PHASE_READ, unit->profile);
 
+	mark = profile_begin();
 	Lexer lexer;
 	LexerOutput lexer_output = lexer.lex(srcfile);
 	if (lexer_output.error_occured == ETHER_ERROR) {
 		ether_abort_no_args();
 	}
+	unit->tokens = lexer_output.tokens;
+	profile_end(mark, PHASE_LEX, unit->profile);
+	stats_count_tokens(unit->tokens);
 
 #if PRINT_TOKEN
-	for (auto it = lexer_output.tokens->begin();
-		 it != lexer_output.tokens->end(); 
-		 ++it) {
-		Token* token = *it;
+	output_mutex.lock();
+	buf_loop(lexer_output.tokens, t) {
+		Token* token = &lexer_output.tokens[t];
+		u64 line, column;
+		get_position_at(srcfile, token->offset, &line, &column);
 		fprintf(stderr, " Token: %40s (%2d) at | %5lu col %5lu |\n",
 				token->lexeme,
 				token->type,
-				token->line,
-				token->column);
+				line,
+				column);
 	}
+	output_mutex.unlock();
 #endif
 
+	mark = profile_begin();
+	unit->ast_arena = new AstArena();
 	Parser parser;
-	ParserOutput parser_output = parser.parse(lexer_output.tokens, srcfile);
+	ParserOutput parser_output = parser.parse(lexer_output.tokens, srcfile, unit->ast_arena);
 	if (parser_output.error_occured == ETHER_ERROR) {
 		ether_abort_no_args();
 	}
-	buf_push(file_decls, (FileDecl){ const_cast<char*>(in_file),
-				parser_output.decls});
-	parser.add_pending_imports();
+	unit->stmts = parser_output.stmts;
+	unit->decls = parser_output.decls;
+	unit->imports = parser_output.imports;
+	profile_end(mark, PHASE_PARSE, unit->profile);
+	stats_count_ast(unit->stmts);
+
+#if PRINT_AST_STATS
+	output_mutex.lock();
+	ast_arena_print_stats(unit->ast_arena, srcfile->fpath);
+	output_mutex.unlock();
+#endif
+	profile_file_end(unit_mark, unit->profile);
+}
+
+static void error_import(CompileUnit* unit, ImportDecl* import, const char* fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	print_error_at(unit->srcfile,
+				   import->token->offset,
+				   import->token->char_count,
+				   fmt,
+				   ap);
+	va_end(ap);
+}
+
+static CompileUnit** visit_stack = null;
+
+/* depth-first walk that orders units by import depth; returns false if
+ * an import cycle was reported */
+static bool check_import_cycles(CompileUnit* unit) {
+	bool no_cycle = true;
+	unit->visit = CUV_VISITING;
+	buf_push(visit_stack, unit);
+
+	buf_loop(unit->import_units, i) {
+		CompileUnit* dep = unit->import_units[i];
+		if (dep->visit == CUV_VISITING) {
+			std::string cycle;
+			u64 s = buf_len(visit_stack);
+			while (visit_stack[s - 1] != dep) {
+				s--;
+			}
+			for (s--; s < buf_len(visit_stack); s++) {
+				cycle.append(visit_stack[s]->fpath);
+				cycle.append(" -> ");
+			}
+			cycle.append(dep->fpath);
+			error_import(unit, &unit->imports[i], "import cycle: %s;", cycle.c_str());
+			no_cycle = false;
+			continue;
+		}
+		if (dep->visit == CUV_NOT_VISITED) {
+			if (!check_import_cycles(dep)) {
+				no_cycle = false;
+			}
+		}
+		unit->depth = MAX(unit->depth, dep->depth + 1);
+	}
+
+	buf_pop(visit_stack);
+	unit->visit = CUV_VISITED;
+	return no_cycle;
+}
+
+static void generate_unit(CompileUnit* unit) {
+	ProfileMark unit_mark = profile_begin();
+	buf_loop(unit->import_units, i) {
+		Stmt** import_decls = unit->import_units[i]->decls;
+		buf_loop(import_decls, d) {
+			buf_push(unit->stmts, import_decls[d]);
+		}
+	}
 
 #if PRINT_AST
+	output_mutex.lock();
 	AstPrinter ast_printer;
-	ast_printer.print(parser_output.stmts);
+	ast_printer.print(unit->stmts);
+	output_mutex.unlock();
 #endif
 
+	ProfileMark mark = profile_begin();
 	Linker linker;
-	error_code linker_error_code = linker.link(parser_output.stmts);
+	error_code linker_error_code = linker.link(unit->stmts);
 	if (linker_error_code == ETHER_ERROR) {
 		ether_abort_no_args();
 	}
+	profile_end(mark, PHASE_LINK, unit->profile);
 
+	mark = profile_begin();
 	Resolve resolve;
-	error_code resolve_error_code = resolve.resolve(parser_output.stmts);
+	error_code resolve_error_code = resolve.resolve(unit->stmts);
 	if (resolve_error_code == ETHER_ERROR) {
 		ether_abort_no_args();
 	}
-	
+	profile_end(mark, PHASE_RESOLVE, unit->profile);
+
+	mark = profile_begin();
+	ConstantFolder constant_folder;
+	error_code fold_error_code = constant_folder.fold(unit->stmts, unit->ast_arena);
+	if (fold_error_code == ETHER_ERROR) {
+		ether_abort_no_args();
+	}
+	profile_end(mark, PHASE_FOLD, unit->profile);
+
+	/* every backend generates from the IR */
+	mark = profile_begin();
+	IrBuilder ir_builder;
+	IrUnit* ir = ir_builder.build(unit->stmts);
+#if PRINT_IR
+	output_mutex.lock();
+	IrPrinter ir_printer;
+	char* ir_text = ir_printer.print(ir);
+	fwrite(ir_text, 1, buf_len(ir_text), stdout);
+	buf_free(ir_text);
+	output_mutex.unlock();
+#endif
+	if (compile_backend == BACKEND_CHECK_IR) {
+		bool ir_ok = ir_check(ir, unit->stmts);
+		ir_free(ir);
+		if (!ir_ok) {
+			ether_abort("%s: the IR fails its check;", unit->fpath);
+		}
+		profile_end(mark, PHASE_IR, unit->profile);
+		profile_file_end(unit_mark, unit->profile);
+		return;
+	}
+#ifdef _DEBUG
+	/* the IR must survive its own dump */
+	assert(ir_check(ir, unit->stmts));
+#endif
+	profile_end(mark, PHASE_IR, unit->profile);
+
+	std::string current_file = std::string(unit->fpath);
+	char* obj_fpath = change_extension(current_file, "o");
+	if (compile_backend == BACKEND_NASM) {
+		mark = profile_begin();
+		char* asm_fpath = change_extension(current_file, "asm");
+		AsmGenerator asm_generator;
+		error_code asm_gen_error_code = asm_generator.generate(unit->stmts, ir, asm_fpath);
+		ir_free(ir);
+		if (asm_gen_error_code == ETHER_ERROR) {
+			ether_abort_no_args();
+		}
+		profile_end(mark, PHASE_CODE_GEN, unit->profile);
+
+		mark = profile_begin();
+		if (run_assembler(asm_fpath, obj_fpath) == ETHER_ERROR) {
+			ether_abort_no_args();
+		}
+		profile_end(mark, PHASE_BACKEND, unit->profile);
+		profile_file_end(unit_mark, unit->profile);
+		return;
+	}
+
+	mark = profile_begin();
+	char* c_fpath = change_extension(current_file, "c");
 	CodeGenerator code_generator;
-	code_generator.generate(parser_output.stmts, const_cast<char*>(obj_fpath));
+	error_code code_gen_error_code = code_generator.generate(unit->stmts, ir, c_fpath);
+	ir_free(ir);
+	if (code_gen_error_code == ETHER_ERROR) {
+		ether_abort_no_args();
+	}
+	profile_end(mark, PHASE_CODE_GEN, unit->profile);
+
+	mark = profile_begin();
+	if (run_c_compiler(c_fpath, obj_fpath) == ETHER_ERROR) {
+		ether_abort_no_args();
+	}
+	profile_end(mark, PHASE_BACKEND, unit->profile);
+	profile_file_end(unit_mark, unit->profile);
+}
+
+void Compiler::compile(char** fpaths, u64 jobs, Backend backend) {
+	compile_jobs = jobs;
+	compile_backend = backend;
+
+	buf_loop(fpaths, f) {
+		char* canonical_fpath = canonicalize_fpath(fpaths[f]);
+		if (!canonical_fpath) {
+			ether_abort("%s: no such file or directory", fpaths[f]);
+		}
+		add_compile_unit(fpaths[f], canonical_fpath);
+	}
+
+	/* lex and parse breadth-first: every wave holds the units first
+	 * imported by the previous one */
+	u64 wave_start = 0;
+	while (wave_start < buf_len(compile_units)) {
+		u64 wave_end = buf_len(compile_units);
+		compile_units_parallel(compile_units + wave_start,
+							   wave_end - wave_start,
+							   parse_unit);
+
+		for (u64 u = wave_start; u < wave_end; u++) {
+			CompileUnit* unit = compile_units[u];
+			ProfileMark mark = profile_begin();
+			buf_loop(unit->imports, i) {
+				CompileUnit* dep = add_compile_unit(unit->imports[i].fpath,
+													unit->imports[i].canonical_fpath);
+				buf_push(unit->import_units, dep);
+			}
+			profile_end(mark, PHASE_IMPORTS, unit->profile);
+		}
+		wave_start = wave_end;
+	}
+
+	/* ordering the units is import work of the whole run */
+	ProfileMark mark = profile_begin();
+	bool no_cycle = true;
+	buf_loop(compile_units, u) {
+		if (compile_units[u]->visit == CUV_NOT_VISITED &&
+			!check_import_cycles(compile_units[u])) {
+			no_cycle = false;
+		}
+	}
+	buf_free(visit_stack);
+	if (!no_cycle) {
+		ether_abort_no_args();
+	}
+
+	/* a unit is generated only after every unit it imports */
+	u64 max_depth = 0;
+	buf_loop(compile_units, u) {
+		max_depth = MAX(max_depth, compile_units[u]->depth);
+	}
+	profile_end(mark, PHASE_IMPORTS, null);
+	CompileUnit** wave = null;
+	for (u64 depth = 0; depth <= max_depth; depth++) {
+		buf_clear(wave);
+		buf_loop(compile_units, u) {
+			if (compile_units[u]->depth == depth) {
+				buf_push(wave, compile_units[u]);
+			}
+		}
+		compile_units_parallel(wave, buf_len(wave), generate_unit);
+	}
+	buf_free(wave);
 
-	return parser_output.decls;
+	/* held until free_compile_units */
+	buf_loop(compile_units, u) {
+		CompileUnit* unit = compile_units[u];
+		u64 ast_bytes = 0;
+		for (u64 k = 0; k < _AST_NODE_KIND_COUNT; k++) {
+			if (k != AST_TOKEN) ast_bytes += unit->ast_arena->node_bytes[k];
+		}
+		profile_memory(MEM_TOKENS,
+					   buf_cap(unit->tokens) * sizeof(Token) +
+					   unit->ast_arena->node_bytes[AST_TOKEN]);
+		profile_memory(MEM_AST, ast_bytes);
+	}
+}
+
+void free_compile_units() {
+	buf_loop(compile_units, u) {
+		CompileUnit* unit = compile_units[u];
+		buf_free(unit->stmts);
+		buf_free(unit->decls);
+		buf_free(unit->imports);
+		buf_free(unit->import_units);
+		buf_free(unit->tokens);
+		if (unit->ast_arena) {
+			ast_arena_free(unit->ast_arena);
+			delete unit->ast_arena;
+		}
+		/* last, since tokens point into the contents */
+		if (unit->srcfile) {
+			free_file(unit->srcfile);
+		}
+		delete unit;
+	}
+	buf_free(compile_units);
 }
@@ -0,0 +1,790 @@
+#include <ether.hpp>
+#include <const_fold.hpp>
+#include <stmt.hpp>
+#include <expr.hpp>
+#include <data_type.hpp>
+#include <token.hpp>
+#include <ast_arena.hpp>
+#include <ir.hpp>
+#include <profile.hpp>
+
+/* the width of an integer type in bits. char is a signed byte, as in
+ * both backends */
+static u32 int_bits(DataType* data_type) {
+	DataType* canonical = data_type->canonical;
+	if (canonical == data_types.t_char ||
+		canonical == data_types.t_u8 ||
+		canonical == data_types.t_i8) {
+		return 8;
+	}
+	if (canonical == data_types.t_u16 ||
+		canonical == data_types.t_i16) {
+		return 16;
+	}
+	if (canonical == data_types.t_int ||
+		canonical == data_types.t_uint ||
+		canonical == data_types.t_u32 ||
+		canonical == data_types.t_i32) {
+		return 32;
+	}
+	return 64;
+}
+
+static bool int_signed(DataType* data_type) {
+	DataType* canonical = data_type->canonical;
+	return (canonical == data_types.t_int ||
+			canonical == data_types.t_i8 ||
+			canonical == data_types.t_i16 ||
+			canonical == data_types.t_i32 ||
+			canonical == data_types.t_i64 ||
+			canonical == data_types.t_char);
+}
+
+/* f32 has no literal, so values of it are never folded */
+static ConstKind const_kind(DataType* data_type) {
+	if (!data_type || data_type->is_array || data_type->pointer_count != 0) {
+		return CK_NONE;
+	}
+	if (data_type->canonical == data_types.t_bool) {
+		return CK_BOOL;
+	}
+	if (data_type->canonical == data_types.t_f64) {
+		return CK_FLOAT;
+	}
+	if (data_type_integer(data_type) == DT_MATCH ||
+		data_type->canonical == data_types.t_char) {
+		return CK_INT;
+	}
+	return CK_NONE;
+}
+
+static u64 int_normalize(DataType* data_type, u64 value) {
+	u32 bits = int_bits(data_type);
+	if (bits == 64) {
+		return value;
+	}
+
+	u64 mask = ((u64)1 << bits) - 1;
+	value &= mask;
+	if (int_signed(data_type) && (value >> (bits - 1))) {
+		value |= ~mask;
+	}
+	return value;
+}
+
+/* C computes below 32 bits in int, so a narrow result is only folded
+ * when it did not wrap */
+static bool int_exact(DataType* data_type, u64 value) {
+	return (int_bits(data_type) >= 32 ||
+			int_normalize(data_type, value) == value);
+}
+
+static ConstValue const_value(Expr* expr) {
+	ConstValue value = {};
+	value.kind = const_kind(expr->data_type);
+	switch (expr->type) {
+	case E_NUMBER:
+		if (value.kind == CK_INT && expr->number->type == T_INTEGER) {
+			char* lexeme = expr->number->lexeme;
+			value.i = (lexeme[0] == '-' ?
+					   (u64)strtoll(lexeme, null, 10) :
+					   strtoull(lexeme, null, 10));
+			/* a literal too big for its type is left to the backend */
+			if (int_normalize(expr->data_type, value.i) != value.i) {
+				value.kind = CK_NONE;
+			}
+			return value;
+		}
+		if (value.kind == CK_FLOAT && expr->number->type == T_FLOAT64) {
+			value.f = strtod(expr->number->lexeme, null);
+			return value;
+		}
+		break;
+	case E_CHAR:
+		if (value.kind == CK_INT) {
+			value.i = int_normalize(expr->data_type, ir_char_value(expr->chr->lexeme));
+			return value;
+		}
+		break;
+	case E_CONSTANT:
+		if (value.kind == CK_BOOL) {
+			value.i = (expr->constant->keyword == KW_TRUE ? 1 : 0);
+			return value;
+		}
+		break;
+	default:
+		break;
+	}
+	value.kind = CK_NONE;
+	return value;
+}
+
+error_code ConstantFolder::fold(Stmt** _stmts, AstArena* _ast_arena) {
+	stmts = _stmts;
+	ast_arena = _ast_arena;
+	constants = {};
+	written = {};
+	error_count = 0;
+
+	/* imported decls belong to the unit that declares them, and have
+	 * neither initializers nor bodies here */
+	buf_loop(stmts, s) {
+		Stmt* stmt = stmts[s];
+		ProfileMark mark = profile_stmt_begin();
+		if (stmt->type == S_VAR_DECL &&
+			stmt->var_decl.is_variable &&
+			stmt->var_decl.initializer) {
+			fold_expr(stmt->var_decl.initializer);
+		}
+		else if (stmt->type == S_FUNC_DECL &&
+				 stmt->func_decl.is_function) {
+			fold_func_decl(stmt);
+		}
+		profile_stmt_end(mark, PHASE_FOLD, stmt);
+	}
+
+	map_free(&constants);
+	map_free(&written);
+	return (error_count == 0 ?
+			ETHER_SUCCESS :
+			ETHER_ERROR);
+}
+
+/* a local read before an assignment further down is still not a
+ * constant, so the writes are found first */
+void ConstantFolder::fold_func_decl(Stmt* stmt) {
+	buf_loop(stmt->func_decl.body, s) {
+		find_written_stmt(stmt->func_decl.body[s]);
+	}
+	fold_body(stmt->func_decl.body);
+}
+
+void ConstantFolder::find_written_stmt(Stmt* stmt) {
+	switch (stmt->type) {
+	case S_VAR_DECL:
+		if (stmt->var_decl.initializer) {
+			find_written_expr(stmt->var_decl.initializer);
+		}
+		break;
+	case S_IF: {
+		IfBranch* branches[2] = { stmt->if_stmt.if_branch, stmt->if_stmt.else_branch };
+		buf_loop(stmt->if_stmt.elif_branch, b) {
+			IfBranch* branch = stmt->if_stmt.elif_branch[b];
+			find_written_expr(branch->cond);
+			buf_loop(branch->body, s) {
+				find_written_stmt(branch->body[s]);
+			}
+		}
+		for (u64 b = 0; b < 2; b++) {
+			if (!branches[b]) continue;
+			if (branches[b]->cond) {
+				find_written_expr(branches[b]->cond);
+			}
+			buf_loop(branches[b]->body, s) {
+				find_written_stmt(branches[b]->body[s]);
+			}
+		}
+	} break;
+	case S_FOR:
+		find_written_stmt(stmt->for_stmt.counter);
+		find_written_expr(stmt->for_stmt.end);
+		buf_loop(stmt->for_stmt.body, s) {
+			find_written_stmt(stmt->for_stmt.body[s]);
+		}
+		break;
+	case S_SWITCH:
+		find_written_expr(stmt->switch_stmt.cond);
+		buf_loop(stmt->switch_stmt.branches, b) {
+			SwitchBranch* branch = stmt->switch_stmt.branches[b];
+			buf_loop(branch->conds, c) {
+				find_written_expr(branch->conds[c]);
+			}
+			find_written_stmt(branch->stmt);
+		}
+		break;
+	case S_RETURN:
+		if (stmt->return_stmt.to_return) {
+			find_written_expr(stmt->return_stmt.to_return);
+		}
+		break;
+	case S_EXPR_STMT:
+		find_written_expr(stmt->expr_stmt);
+		break;
+	case S_BLOCK:
+		buf_loop(stmt->block, s) {
+			find_written_stmt(stmt->block[s]);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* only a scalar can be a constant, and the only ways to change one
+ * are to assign it or to take its address */
+void ConstantFolder::find_written_expr(Expr* expr) {
+	switch (expr->type) {
+	case E_BINARY:
+		if (expr->binary.op->type == T_EQUAL &&
+			expr->binary.left->type == E_VARIABLE_REF) {
+			Stmt* variable = expr->binary.left->variable_ref.variable_refed;
+			map_put(&written, variable, variable);
+		}
+		find_written_expr(expr->binary.left);
+		find_written_expr(expr->binary.right);
+		break;
+	case E_UNARY:
+		if (expr->unary.op->type == T_AMPERSAND &&
+			expr->unary.right->type == E_VARIABLE_REF) {
+			Stmt* variable = expr->unary.right->variable_ref.variable_refed;
+			map_put(&written, variable, variable);
+		}
+		find_written_expr(expr->unary.right);
+		break;
+	case E_CAST:
+		find_written_expr(expr->cast.right);
+		break;
+	case E_FUNC_CALL:
+		if (expr->func_call.left->type == E_MEMBER_ACCESS) {
+			find_written_expr(expr->func_call.left->member_access.left);
+		}
+		buf_loop(expr->func_call.args, a) {
+			find_written_expr(expr->func_call.args[a]);
+		}
+		break;
+	case E_ARRAY_ACCESS:
+		find_written_expr(expr->array_access.left);
+		find_written_expr(expr->array_access.index);
+		break;
+	case E_MEMBER_ACCESS:
+		find_written_expr(expr->member_access.left);
+		break;
+	default:
+		break;
+	}
+}
+
+void ConstantFolder::fold_body(Stmt** body) {
+	buf_loop(body, s) {
+		fold_stmt(body[s]);
+	}
+}
+
+void ConstantFolder::fold_stmt(Stmt* stmt) {
+	switch (stmt->type) {
+	case S_VAR_DECL:
+		fold_var_decl(stmt);
+		break;
+	case S_IF:
+		fold_if_branch(stmt->if_stmt.if_branch);
+		buf_loop(stmt->if_stmt.elif_branch, b) {
+			fold_if_branch(stmt->if_stmt.elif_branch[b]);
+		}
+		if (stmt->if_stmt.else_branch) {
+			fold_if_branch(stmt->if_stmt.else_branch);
+		}
+		break;
+	case S_FOR:
+		/* the counter changes every iteration */
+		if (stmt->for_stmt.counter->var_decl.initializer) {
+			fold_expr(stmt->for_stmt.counter->var_decl.initializer);
+		}
+		fold_expr(stmt->for_stmt.end);
+		fold_body(stmt->for_stmt.body);
+		break;
+	case S_SWITCH:
+		fold_expr(stmt->switch_stmt.cond);
+		buf_loop(stmt->switch_stmt.branches, b) {
+			SwitchBranch* branch = stmt->switch_stmt.branches[b];
+			buf_loop(branch->conds, c) {
+				fold_expr(branch->conds[c]);
+			}
+			fold_stmt(branch->stmt);
+		}
+		break;
+	case S_RETURN:
+		if (stmt->return_stmt.to_return) {
+			fold_expr(stmt->return_stmt.to_return);
+		}
+		break;
+	case S_EXPR_STMT:
+		fold_expr(stmt->expr_stmt);
+		break;
+	case S_BLOCK:
+		fold_body(stmt->block);
+		break;
+	default:
+		break;
+	}
+}
+
+void ConstantFolder::fold_var_decl(Stmt* stmt) {
+	Expr* initializer = stmt->var_decl.initializer;
+	if (!initializer) {
+		return;
+	}
+
+	fold_expr(initializer);
+	if (const_value(initializer).kind != CK_NONE &&
+		!map_get(&written, stmt)) {
+		map_put(&constants, stmt, initializer);
+	}
+}
+
+void ConstantFolder::fold_if_branch(IfBranch* branch) {
+	if (branch->cond) {
+		fold_expr(branch->cond);
+	}
+	fold_body(branch->body);
+}
+
+void ConstantFolder::fold_expr(Expr* expr) {
+	switch (expr->type) {
+	case E_BINARY:
+		fold_binary_expr(expr);
+		break;
+	case E_UNARY:
+		fold_unary_expr(expr);
+		break;
+	case E_CAST:
+		fold_cast_expr(expr);
+		break;
+	case E_FUNC_CALL:
+		if (expr->func_call.left->type == E_MEMBER_ACCESS) {
+			fold_expr(expr->func_call.left->member_access.left);
+		}
+		buf_loop(expr->func_call.args, a) {
+			fold_expr(expr->func_call.args[a]);
+		}
+		break;
+	case E_ARRAY_ACCESS:
+		fold_expr(expr->array_access.left);
+		fold_expr(expr->array_access.index);
+		break;
+	case E_MEMBER_ACCESS:
+		fold_expr(expr->member_access.left);
+		break;
+	case E_VARIABLE_REF:
+		fold_variable_ref(expr);
+		break;
+	default:
+		break;
+	}
+}
+
+void ConstantFolder::fold_binary_expr(Expr* expr) {
+	TokenType op = expr->binary.op->type;
+	if (op == T_AMPERSAND_AMPERSAND || op == T_BAR_BAR) {
+		fold_logic_binary_expr(expr);
+		return;
+	}
+
+	fold_expr(expr->binary.left);
+	fold_expr(expr->binary.right);
+	if (op == T_EQUAL) {
+		return;
+	}
+
+	ConstValue right = const_value(expr->binary.right);
+	if ((op == T_SLASH || op == T_PERCENT) &&
+		right.kind == CK_INT &&
+		right.i == 0) {
+		error_token(expr->binary.op,
+					"division by zero;");
+		return;
+	}
+
+	ConstValue left = const_value(expr->binary.left);
+	if (left.kind == CK_NONE || right.kind == CK_NONE) {
+		return;
+	}
+
+	switch (op) {
+	case T_PLUS:
+	case T_MINUS:
+	case T_ASTERISK:
+	case T_SLASH:
+	case T_PERCENT:
+		fold_arithmetic_expr(expr, left, right);
+		break;
+
+	case T_AMPERSAND:
+	case T_BAR:
+		if (left.kind == CK_INT) {
+			make_int(expr, (op == T_AMPERSAND ?
+							left.i & right.i :
+							left.i | right.i));
+		}
+		break;
+
+	case T_EQUAL_EQUAL:
+	case T_BANG_EQUAL:
+	case T_LANGBKT:
+	case T_LESS_EQUAL:
+	case T_RANGBKT:
+	case T_GREATER_EQUAL:
+		fold_comparison_expr(expr, left, right);
+		break;
+
+	case T_LESS_LESS:
+	case T_GREATER_GREATER:
+		fold_bitshift_expr(expr, left, right);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/* integers wrap in the width of their type; float results that are
+ * not finite have no literal and are left alone */
+void ConstantFolder::fold_arithmetic_expr(Expr* expr, ConstValue left, ConstValue right) {
+	TokenType op = expr->binary.op->type;
+	if (left.kind == CK_FLOAT) {
+		f64 result;
+		switch (op) {
+		case T_PLUS: result = left.f + right.f; break;
+		case T_MINUS: result = left.f - right.f; break;
+		case T_ASTERISK: result = left.f * right.f; break;
+		case T_SLASH: result = left.f / right.f; break;
+		default: return;
+		}
+		if (isfinite(result)) {
+			make_float(expr, result);
+		}
+		return;
+	}
+	if (left.kind != CK_INT) {
+		return;
+	}
+
+	DataType* data_type = expr->data_type;
+	bool is_signed = int_signed(data_type);
+	u64 result;
+	switch (op) {
+	case T_PLUS:
+		result = left.i + right.i;
+		break;
+	case T_MINUS:
+		result = left.i - right.i;
+		break;
+	case T_ASTERISK:
+		result = left.i * right.i;
+		break;
+	case T_SLASH:
+		if (is_signed) {
+			result = ((i64)right.i == -1 ?
+					  0 - left.i :
+					  (u64)((i64)left.i / (i64)right.i));
+		}
+		else {
+			result = left.i / right.i;
+		}
+		break;
+	case T_PERCENT:
+		if (is_signed) {
+			result = ((i64)right.i == -1 ?
+					  0 :
+					  (u64)((i64)left.i % (i64)right.i));
+		}
+		else {
+			result = left.i % right.i;
+		}
+		break;
+	default:
+		return;
+	}
+
+	if (int_exact(data_type, result)) {
+		make_int(expr, int_normalize(data_type, result));
+	}
+}
+
+void ConstantFolder::fold_comparison_expr(Expr* expr, ConstValue left, ConstValue right) {
+	/* -1, 0 or 1 as left is less than, equal to or greater than right */
+	int order;
+	if (left.kind == CK_FLOAT) {
+		if (isnan(left.f) || isnan(right.f)) {
+			return;
+		}
+		order = (left.f < right.f ? -1 : (left.f > right.f ? 1 : 0));
+	}
+	else if (left.kind == CK_INT && int_signed(expr->binary.left->data_type)) {
+		i64 a = (i64)left.i;
+		i64 b = (i64)right.i;
+		order = (a < b ? -1 : (a > b ? 1 : 0));
+	}
+	else {
+		order = (left.i < right.i ? -1 : (left.i > right.i ? 1 : 0));
+	}
+
+	bool result;
+	switch (expr->binary.op->type) {
+	case T_EQUAL_EQUAL: result = (order == 0); break;
+	case T_BANG_EQUAL: result = (order != 0); break;
+	case T_LANGBKT: result = (order < 0); break;
+	case T_LESS_EQUAL: result = (order <= 0); break;
+	case T_RANGBKT: result = (order > 0); break;
+	case T_GREATER_EQUAL: result = (order >= 0); break;
+	default: return;
+	}
+	make_bool(expr, result);
+}
+
+/* a shift by the width of the type or more, or by a negative count,
+ * means different things in C and on x86, so it is left alone */
+void ConstantFolder::fold_bitshift_expr(Expr* expr, ConstValue left, ConstValue right) {
+	if (left.kind != CK_INT || right.kind != CK_INT) {
+		return;
+	}
+
+	DataType* data_type = expr->data_type;
+	if ((int_signed(expr->binary.right->data_type) && (i64)right.i < 0) ||
+		right.i >= int_bits(data_type)) {
+		return;
+	}
+
+	u64 result;
+	if (expr->binary.op->type == T_LESS_LESS) {
+		result = left.i << right.i;
+	}
+	else if (int_signed(data_type)) {
+		result = (u64)((i64)left.i >> right.i);
+	}
+	else {
+		result = left.i >> right.i;
+	}
+
+	if (int_exact(data_type, result)) {
+		make_int(expr, int_normalize(data_type, result));
+	}
+}
+
+/* the right operand only runs when the left one does not decide the
+ * result, so a deciding constant on the left drops it */
+void ConstantFolder::fold_logic_binary_expr(Expr* expr) {
+	fold_expr(expr->binary.left);
+
+	/* a dropped right operand is not folded either, so it reports
+	 * nothing, not even a division by zero */
+	ConstValue left = const_value(expr->binary.left);
+	bool is_and = (expr->binary.op->type == T_AMPERSAND_AMPERSAND);
+	if (left.kind == CK_BOOL && left.i == (is_and ? 0 : 1)) {
+		make_bool(expr, left.i);
+		return;
+	}
+
+	fold_expr(expr->binary.right);
+	if (left.kind != CK_BOOL) {
+		return;
+	}
+
+	ConstValue right = const_value(expr->binary.right);
+	if (right.kind == CK_BOOL) {
+		make_bool(expr, right.i);
+	}
+}
+
+void ConstantFolder::fold_unary_expr(Expr* expr) {
+	fold_expr(expr->unary.right);
+
+	ConstValue value = const_value(expr->unary.right);
+	DataType* data_type = expr->data_type;
+	switch (expr->unary.op->type) {
+	case T_PLUS:
+		if (value.kind == CK_INT) {
+			make_int(expr, value.i);
+		}
+		else if (value.kind == CK_FLOAT) {
+			make_float(expr, value.f);
+		}
+		break;
+
+	case T_MINUS:
+		if (value.kind == CK_INT && int_exact(data_type, 0 - value.i)) {
+			make_int(expr, int_normalize(data_type, 0 - value.i));
+		}
+		else if (value.kind == CK_FLOAT) {
+			make_float(expr, -value.f);
+		}
+		break;
+
+	case T_TILDE:
+		if (value.kind == CK_INT && int_exact(data_type, ~value.i)) {
+			make_int(expr, int_normalize(data_type, ~value.i));
+		}
+		break;
+
+	case T_BANG:
+		if (value.kind == CK_BOOL) {
+			make_bool(expr, !value.i);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/* conversions follow C. a float that does not fit the integer type it
+ * is cast to has no defined value, so it is left alone */
+void ConstantFolder::fold_cast_expr(Expr* expr) {
+	fold_expr(expr->cast.right);
+
+	ConstValue value = const_value(expr->cast.right);
+	if (value.kind == CK_NONE) {
+		return;
+	}
+
+	DataType* data_type = expr->data_type;
+	switch (const_kind(data_type)) {
+	case CK_INT:
+		if (value.kind == CK_FLOAT) {
+			u32 bits = int_bits(data_type);
+			bool is_signed = int_signed(data_type);
+			f64 truncated = trunc(value.f);
+			f64 min = (is_signed ? -ldexp(1, bits - 1) : 0);
+			f64 max = (is_signed ? ldexp(1, bits - 1) : ldexp(1, bits));
+			if (!(truncated >= min && truncated < max)) {
+				return;
+			}
+			make_int(expr, (is_signed ?
+							(u64)(i64)truncated :
+							(u64)truncated));
+		}
+		else {
+			make_int(expr, int_normalize(data_type, value.i));
+		}
+		break;
+
+	case CK_BOOL:
+		make_bool(expr, (value.kind == CK_FLOAT ?
+						 value.f != 0 :
+						 value.i != 0));
+		break;
+
+	case CK_FLOAT:
+		if (value.kind == CK_FLOAT) {
+			make_float(expr, value.f);
+		}
+		else if (value.kind == CK_INT && int_signed(expr->cast.right->data_type)) {
+			make_float(expr, (f64)(i64)value.i);
+		}
+		else {
+			make_float(expr, (f64)value.i);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void ConstantFolder::fold_variable_ref(Expr* expr) {
+	Expr* literal = (Expr*)map_get(&constants, expr->variable_ref.variable_refed);
+	if (!literal) {
+		return;
+	}
+
+	Token* head = expr->head;
+	Token* tail = expr->tail;
+	*expr = *literal;
+	expr->head = head;
+	expr->tail = tail;
+}
+
+/* value is already in the width of the expression's type. a char that
+ * has a char literal gets one; the minimum of a signed type has no
+ * literal in C, so it is left alone */
+void ConstantFolder::make_int(Expr* expr, u64 value) {
+	DataType* data_type = expr->data_type;
+	char lexeme[32];
+	if (data_type->canonical == data_types.t_char) {
+		char ch = (char)value;
+		char* escape = null;
+		switch (ch) {
+		case '\n': escape = "\\n"; break;
+		case '\r': escape = "\\r"; break;
+		case '\t': escape = "\\t"; break;
+		case '\0': escape = "\\0"; break;
+		case '\\': escape = "\\\\"; break;
+		case '\'': escape = "\\'"; break;
+		default: break;
+		}
+		if (escape) {
+			make_literal(expr, E_CHAR, escape, T_CHAR);
+			return;
+		}
+		if (ch >= ' ' && ch <= '~') {
+			lexeme[0] = ch;
+			lexeme[1] = '\0';
+			make_literal(expr, E_CHAR, lexeme, T_CHAR);
+			return;
+		}
+	}
+
+	if (int_signed(data_type)) {
+		if (value == ((u64)-1 << (int_bits(data_type) - 1))) {
+			return;
+		}
+		snprintf(lexeme, sizeof(lexeme), "%ld", (i64)value);
+	}
+	else {
+		snprintf(lexeme, sizeof(lexeme), "%lu", value);
+	}
+	make_literal(expr, E_NUMBER, lexeme, T_INTEGER);
+}
+
+/* printed so that it reads back as the same double, and always with a
+ * point or an exponent so C takes it for one */
+void ConstantFolder::make_float(Expr* expr, f64 value) {
+	char lexeme[40];
+	snprintf(lexeme, sizeof(lexeme), "%.17g", value);
+	if (!strpbrk(lexeme, ".e")) {
+		strcat(lexeme, ".0");
+	}
+	make_literal(expr, E_NUMBER, lexeme, T_FLOAT64);
+}
+
+void ConstantFolder::make_bool(Expr* expr, bool value) {
+	KeywordType keyword = (value ? KW_TRUE : KW_FALSE);
+	make_literal(expr, E_CONSTANT, keywords[keyword], T_KEYWORD);
+	expr->constant->keyword = keyword;
+}
+
+/* the literal's token sits where the expression starts, and head and
+ * tail still span the whole expression for diagnostics */
+void ConstantFolder::make_literal(Expr* expr, ExprType type, char* lexeme, TokenType token_type) {
+	Token* token = token_create(ast_arena,
+								str_intern(lexeme),
+								expr->head->offset,
+								expr->head->char_count,
+								token_type,
+								expr->head->file_id);
+	expr->type = type;
+	switch (type) {
+	case E_NUMBER: expr->number = token; break;
+	case E_CHAR: expr->chr = token; break;
+	case E_CONSTANT: expr->constant = token; break;
+	default: assert(0); break;
+	}
+}
+
+void ConstantFolder::error_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
+	print_error_at(
+		srcfile,
+		offset,
+		char_count,
+		fmt,
+		ap);
+	error_count++;
+}
+
+void ConstantFolder::warning_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
+	print_warning_at(
+		srcfile,
+		offset,
+		char_count,
+		fmt,
+		ap);
+}
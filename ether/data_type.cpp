@@ -1,97 +1,230 @@
 #include <data_type.hpp>
 #include <token.hpp>
+#include <ast_arena.hpp>
+#include <stats.hpp>
+
+#include <mutex>
+
+/* canonical types live as long as the compiler. parsers on different
+ * threads look types up concurrently; creating one takes the lock */
+static std::mutex canonical_mutex;
+static AstArena canonical_arena;
+/* lookups probe these without locking, like the string interner */
+static SharedMap base_types;	/* identifier lexeme -> DataType* */
+static SharedMap pointer_types;	/* DataType* -> DataType* with one more pointer */
+static SharedMap array_types;	/* element DataType*, elem count lexeme -> DataType* */
+/* canonical DataType* -> its rendering, allocated from type_string_arena */
+static SharedMap type_strings;
+static Arena type_string_arena;
+
+static u64 canonical_hash(void* key, void* sub_key) {
+	return hash_u64(hash_ptr(key) ^ (u64)sub_key);
+}
+
+static void* canonical_map_get(SharedMap* map, void* key, void* sub_key) {
+	SharedTable* table = shared_map_table(map);
+	if (!table) return null;
+	u64 collisions;
+	SharedEntry* entry = shared_table_find(table, canonical_hash(key, sub_key), &collisions, [&](void* entry_key, SharedEntry* e) {
+		return entry_key == key && e->sub_key == sub_key;
+	});
+	return (entry ? entry->val : null);
+}
+
+/* the caller holds canonical_mutex and has checked that key is absent */
+static void canonical_map_put(SharedMap* map, void* key, void* sub_key, void* val) {
+	assert(!canonical_map_get(map, key, sub_key));
+	shared_map_put(map, canonical_hash(key, sub_key), key, sub_key, val);
+}
 
 PredefinedDataTypes data_types;
 
 void sys_data_type_init() {
-	data_types.t_int = data_type_from_string("int");
-	data_types.t_uint = data_type_from_string("uint");
-	data_types.t_string = data_type_from_string_int("char", 1);
-	data_types.t_char = data_type_from_string("char");
-	data_types.t_bool = data_type_from_string("bool");
-	data_types.t_void_pointer = data_type_from_string_int("void", 1);
-	data_types.t_f32 = data_type_from_string("f32");
-	data_types.t_f64 = data_type_from_string("f64");
+	data_types.t_int = data_type_canonical(str_intern("int"), 0, false, null);
+	data_types.t_uint = data_type_canonical(str_intern("uint"), 0, false, null);
+	data_types.t_string = data_type_canonical(str_intern("char"), 1, false, null);
+	data_types.t_char = data_type_canonical(str_intern("char"), 0, false, null);
+	data_types.t_bool = data_type_canonical(str_intern("bool"), 0, false, null);
+	data_types.t_void_pointer = data_type_canonical(str_intern("void"), 1, false, null);
+	data_types.t_f32 = data_type_canonical(str_intern("f32"), 0, false, null);
+	data_types.t_f64 = data_type_canonical(str_intern("f64"), 0, false, null);
+	data_types.t_void = data_type_canonical(str_intern("void"), 0, false, null);
 	
-	data_types.t_u8 = data_type_from_string("u8");
-	data_types.t_u16 = data_type_from_string("u16");
-	data_types.t_u32 = data_type_from_string("u32");
-	data_types.t_u64 = data_type_from_string("u64");
-	data_types.t_i8 = data_type_from_string("i8");
-	data_types.t_i16 = data_type_from_string("i16");
-	data_types.t_i32 = data_type_from_string("i32");
-	data_types.t_i64 = data_type_from_string("i64");
+	data_types.t_u8 = data_type_canonical(str_intern("u8"), 0, false, null);
+	data_types.t_u16 = data_type_canonical(str_intern("u16"), 0, false, null);
+	data_types.t_u32 = data_type_canonical(str_intern("u32"), 0, false, null);
+	data_types.t_u64 = data_type_canonical(str_intern("u64"), 0, false, null);
+	data_types.t_i8 = data_type_canonical(str_intern("i8"), 0, false, null);
+	data_types.t_i16 = data_type_canonical(str_intern("i16"), 0, false, null);
+	data_types.t_i32 = data_type_canonical(str_intern("i32"), 0, false, null);
+	data_types.t_i64 = data_type_canonical(str_intern("i64"), 0, false, null);
+
+	DataType** predef_data_types_array = &(data_types.t_int);
+	for (u64 i = 0; i < _DT_INTEGER_TYPE_COUNT; i++) {
+		predef_data_types_array[i]->flags |= DT_FLAG_INTEGER;
+	}
 }
 
-DataType* data_type_create(Token* identifier, u8 pointer_count, bool is_array, Token* array_elem_count, Token* start) {
-	DataType* data_type = new DataType();
+static DataType* canonical_create(Token* identifier, u8 pointer_count, bool is_array, Token* array_elem_count) {
+	DataType* data_type = AST_NEW(&canonical_arena, AST_DATA_TYPE, DataType);
 	data_type->identifier = identifier;
 	data_type->pointer_count = pointer_count;
 	data_type->is_array = is_array;
 	data_type->array_elem_count = array_elem_count;
-	data_type->start = start;
+	data_type->start = identifier;
+	data_type->canonical = data_type;
 	return data_type;
 }
 
-DataType* data_type_from_string(char* type) {
-	Token* identifier = token_from_string(type);
-	return data_type_create(identifier,
-							0,
-							false,
-							null,
-							identifier);
-}
+/* the same walk as data_type_canonical, but only through types that
+ * already exist, so it needs no lock */
+static DataType* canonical_find(char* identifier, u8 pointer_count, bool is_array, char* array_elem_count) {
+	DataType* data_type = (DataType*)canonical_map_get(&base_types, identifier, null);
+	for (u8 p = 0; data_type && p < pointer_count; p++) {
+		data_type = (DataType*)canonical_map_get(&pointer_types, data_type, null);
+	}
 
-DataType* data_type_from_string_int(char* type, u8 pointer_count) {
-	Token* identifier = token_from_string(type);
-	return data_type_create(identifier,
-							pointer_count,
-							false,
-							null,
-							identifier);
+	if (data_type && is_array) {
+		data_type = (DataType*)canonical_map_get(&array_types, data_type, array_elem_count);
+	}
+	return data_type;
 }
 
-DataTypeMatch data_type_match(DataType* a, DataType* b) {
-	if (a && b) {
-		if (a->is_array != b->is_array) {
-			return DT_NOT_MATCH;
-		}
-		if (a->is_array) {
-			if (!is_token_equal(a->array_elem_count, b->array_elem_count)) {
-				return DT_NOT_MATCH;
-			}
-		}
+/* built up one layer at a time: the base type, then each pointer,
+ * then the array, the same order the parser reads them in reverse */
+DataType* data_type_canonical(char* identifier, u8 pointer_count, bool is_array, char* array_elem_count) {
+	DataType* data_type = canonical_find(identifier, pointer_count, is_array, array_elem_count);
+	if (data_type) return data_type;
+
+	/* another thread may create the same layers before the lock is
+	 * taken, so each one is looked up again under it */
+	std::lock_guard<std::mutex> lock(canonical_mutex);
+	data_type = (DataType*)canonical_map_get(&base_types, identifier, null);
+	if (!data_type) {
+		data_type = canonical_create(token_from_string(&canonical_arena, identifier),
+									 0,
+									 false,
+									 null);
+		canonical_map_put(&base_types, identifier, null, data_type);
+	}
 
-		if (a->pointer_count != b->pointer_count) {
-			return DT_NOT_MATCH;
+	for (u8 p = 0; p < pointer_count; p++) {
+		DataType* pointer = (DataType*)canonical_map_get(&pointer_types, data_type, null);
+		if (!pointer) {
+			pointer = canonical_create(data_type->identifier,
+									   data_type->pointer_count + 1,
+									   false,
+									   null);
+			canonical_map_put(&pointer_types, data_type, null, pointer);
 		}
+		data_type = pointer;
+	}
 
-		if (!is_token_equal(a->identifier, b->identifier)) {
-			return DT_NOT_MATCH;
+	if (is_array) {
+		DataType* array = (DataType*)canonical_map_get(&array_types, data_type, array_elem_count);
+		if (!array) {
+			array = canonical_create(data_type->identifier,
+									 data_type->pointer_count,
+									 true,
+									 token_from_string(&canonical_arena, array_elem_count));
+			canonical_map_put(&array_types, data_type, array_elem_count, array);
 		}
+		data_type = array;
+	}
+	return data_type;
+}
 
+DataType* data_type_create(AstArena* ast_arena, Token* identifier, u8 pointer_count, bool is_array, Token* array_elem_count, Token* start) {
+	DataType* data_type = AST_NEW(ast_arena, AST_DATA_TYPE, DataType);
+	data_type->identifier = identifier;
+	data_type->pointer_count = pointer_count;
+	data_type->is_array = is_array;
+	data_type->array_elem_count = array_elem_count;
+	data_type->start = start;
+	data_type->canonical = data_type_canonical(identifier->lexeme,
+											   pointer_count,
+											   is_array,
+											   (is_array ?
+												array_elem_count->lexeme :
+												null));
+	data_type->flags = data_type->canonical->flags;
+	return data_type;
+}
+
+DataType* data_type_from_string(AstArena* ast_arena, char* type) {
+	Token* identifier = token_from_string(ast_arena, type);
+	return data_type_create(ast_arena,
+							identifier,
+							0,
+							false,
+							null,
+							identifier);
+}
+
+DataTypeMatch data_type_match(DataType* a, DataType* b) {
+	STAT_INC(STAT_DATA_TYPE_MATCHES);
+	if (a && b && a->canonical == b->canonical) {
 		return DT_MATCH;
 	}
-	
 	return DT_NOT_MATCH;
 }
 
 DataTypeMatch data_type_integer(DataType* data_type) {
-	if (data_type) {
-		DataType** predef_data_types_array = &(data_types.t_int);
-		bool integer_match = false;
-		for (u64 i = 0; i < _DT_INTEGER_TYPE_COUNT; i++) {
-			DataTypeMatch match = data_type_match(data_type, predef_data_types_array[i]);
-			if (match != DT_NOT_MATCH) {
-				integer_match = true;
-				break;
-			}
-		}
+	if (data_type && (data_type->flags & DT_FLAG_INTEGER)) {
+		return DT_MATCH;
+	}
+	return DT_NOT_MATCH;
+}
 
-		if (integer_match) {
-			return DT_MATCH;
-		}
+/* renders a type as it is written in source, e.g. "[4]^char". each
+ * canonical type is rendered once; the string lives as long as the
+ * compiler */
+char* data_type_to_string(DataType* data_type) {
+	DataType* canonical = data_type->canonical;
+	char* str = (char*)canonical_map_get(&type_strings, canonical, null);
+	if (str) return str;
+
+	std::lock_guard<std::mutex> lock(canonical_mutex);
+	str = (char*)canonical_map_get(&type_strings, canonical, null);
+	if (str) return str;
+
+	u64 identifier_len = strlen(canonical->identifier->lexeme);
+	u64 array_elem_count_len = 0;
+	u64 len = identifier_len + canonical->pointer_count;
+	if (canonical->is_array) {
+		array_elem_count_len = strlen(canonical->array_elem_count->lexeme);
+		len += array_elem_count_len + 2;
 	}
 
-	return DT_NOT_MATCH;
+	str = (char*)arena_alloc_aligned(&type_string_arena, len + 1, 1);
+	u64 idx = 0;
+	if (canonical->is_array) {
+		str[idx++] = '[';
+		memcpy(str + idx, canonical->array_elem_count->lexeme, array_elem_count_len);
+		idx += array_elem_count_len;
+		str[idx++] = ']';
+	}
+
+	for (u8 p = 0; p < canonical->pointer_count; p++) {
+		str[idx++] = '^';
+	}
+
+	memcpy(str + idx, canonical->identifier->lexeme, identifier_len);
+	idx += identifier_len;
+	assert(idx == len);
+	str[len] = '\0';
+
+	canonical_map_put(&type_strings, canonical, null, str);
+	return str;
+}
+
+/* canonical types with the tables that find them, and their renderings */
+void data_type_memory(u64* canonical_bytes, u64* string_bytes) {
+	std::lock_guard<std::mutex> lock(canonical_mutex);
+	*canonical_bytes = (canonical_arena.arena.bytes_allocated +
+						shared_map_bytes(&base_types) +
+						shared_map_bytes(&pointer_types) +
+						shared_map_bytes(&array_types));
+	*string_bytes = (type_string_arena.bytes_allocated +
+					 shared_map_bytes(&type_strings));
 }
@@ -1,7 +1,10 @@
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
 #include <assert.h>
 #include <ds.hpp>
 #include <math.hpp>
+#include <stats.hpp>
 
 void* buf__grow_raw(const void* buf, u64 new_len, u64 elem_size) {
 	assert(buf_cap(buf) <= (__SIZE_MAX__ - 1) / 2);
@@ -11,7 +14,10 @@ void* buf__grow_raw(const void* buf, u64 new_len, u64 elem_size) {
 	u64 new_size = offsetof(BufHdr, buf) + (new_cap * elem_size);
 	BufHdr* new_hdr;
 
+	STAT_INC(STAT_BUF_GROWS);
+	STAT_ADD(STAT_BUF_BYTES_GROWN, (new_cap - buf_cap(buf)) * elem_size);
 	if (buf) {
+		STAT_ADD(STAT_BUF_BYTES_COPIED, buf_len(buf) * elem_size);
 		new_hdr = (BufHdr*)realloc(buf__hdr(buf), new_size);
 	}
 	else {
@@ -23,6 +29,42 @@ void* buf__grow_raw(const void* buf, u64 new_len, u64 elem_size) {
 	return new_hdr->buf;
 }
 
+static void arena_grow(Arena* arena, u64 min_size) {
+	u64 size = CLAMP_MIN(ALIGN_UP(min_size, ARENA_ALIGNMENT), ARENA_BLOCK_SIZE);
+	arena->ptr = (char*)malloc(size);
+	assert(arena->ptr == ALIGN_DOWN_PTR(arena->ptr, ARENA_ALIGNMENT));
+	arena->end = arena->ptr + size;
+	buf_push(arena->blocks, arena->ptr);
+}
+
+void* arena_alloc_aligned(Arena* arena, u64 size, u64 align) {
+	char* ptr = (char*)ALIGN_UP_PTR(arena->ptr, align);
+	if (size > (u64)(arena->end - ptr) || !arena->ptr) {
+		arena_grow(arena, size);
+		ptr = arena->ptr;
+	}
+	arena->ptr = ptr + size;
+	assert(arena->ptr <= arena->end);
+	arena->alloc_count++;
+	arena->bytes_allocated += size;
+	return ptr;
+}
+
+void* arena_alloc(Arena* arena, u64 size) {
+	return arena_alloc_aligned(arena, size, ARENA_ALIGNMENT);
+}
+
+void arena_free(Arena* arena) {
+	buf_loop(arena->blocks, b) {
+		free(arena->blocks[b]);
+	}
+	buf_free(arena->blocks);
+	arena->ptr = null;
+	arena->end = null;
+	arena->alloc_count = 0;
+	arena->bytes_allocated = 0;
+}
+
 void buf__shrink(const void* buf, u64 size) {
 	if (size > buf_len(buf)) {
 		size = buf_len(buf);
@@ -30,3 +72,213 @@ void buf__shrink(const void* buf, u64 size) {
 
 	buf__hdr(buf)->len -= size;
 }
+
+/* appends the formatted string, keeping the buffer '\0' terminated;
+ * the terminator is not counted in buf_len */
+char* buf__printf(char* buf, const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	u64 cap = buf_cap(buf) - buf_len(buf);
+	u64 n = 1 + vsnprintf(buf_end(buf), cap, fmt, args);
+	va_end(args);
+	if (n > cap) {
+		buf_fit(buf, n + buf_len(buf));
+		va_start(args, fmt);
+		u64 new_cap = buf_cap(buf) - buf_len(buf);
+		n = 1 + vsnprintf(buf_end(buf), new_cap, fmt, args);
+		assert(n <= new_cap);
+		va_end(args);
+	}
+	buf__hdr(buf)->len += n - 1;
+	return buf;
+}
+
+u64 hash_u64(u64 x) {
+	x *= 0xff51afd7ed558ccd;
+	x ^= x >> 32;
+	return x;
+}
+
+u64 hash_ptr(const void* ptr) {
+	return hash_u64((uintptr_t)ptr);
+}
+
+u64 hash_bytes(const void* ptr, u64 len) {
+	/* FNV-1a with an extra fold of the high bits */
+	u64 x = 0xcbf29ce484222325;
+	const char* buf = (const char*)ptr;
+	for (u64 i = 0; i < len; i++) {
+		x ^= buf[i];
+		x *= 0x100000001b3;
+		x ^= x >> 32;
+	}
+	return x;
+}
+
+static void map_grow(Map* map, u64 new_cap) {
+	new_cap = CLAMP_MIN(new_cap, 16);
+	Map new_map = {
+		(u64*)calloc(new_cap, sizeof(u64)),
+		(u64*)malloc(new_cap * sizeof(u64)),
+		0,
+		new_cap,
+	};
+	for (u64 i = 0; i < map->cap; i++) {
+		if (map->keys[i]) {
+			map_put_u64_from_u64(&new_map, map->keys[i], map->vals[i]);
+		}
+	}
+	free(map->keys);
+	free(map->vals);
+	*map = new_map;
+}
+
+u64 map_get_u64_from_u64(Map* map, u64 key) {
+	if (map->len == 0) return 0;
+	u64 i = hash_u64(key);
+	for (;;) {
+		i &= map->cap - 1;
+		if (map->keys[i] == key) {
+			return map->vals[i];
+		}
+		else if (!map->keys[i]) {
+			return 0;
+		}
+		i++;
+	}
+}
+
+void map_put_u64_from_u64(Map* map, u64 key, u64 val) {
+	assert(key);
+	if (!val) return;
+	if (2 * map->len >= map->cap) {
+		map_grow(map, 2 * map->cap);
+	}
+	assert(2 * map->len < map->cap);
+	u64 i = hash_u64(key);
+	for (;;) {
+		i &= map->cap - 1;
+		if (!map->keys[i]) {
+			map->len++;
+			map->keys[i] = key;
+			map->vals[i] = val;
+			return;
+		}
+		else if (map->keys[i] == key) {
+			map->vals[i] = val;
+			return;
+		}
+		i++;
+	}
+}
+
+void* map_get(Map* map, const void* key) {
+	return (void*)(uintptr_t)map_get_u64_from_u64(map, (u64)(uintptr_t)key);
+}
+
+void map_put(Map* map, const void* key, void* val) {
+	map_put_u64_from_u64(map, (u64)(uintptr_t)key, (u64)(uintptr_t)val);
+}
+
+void map_remove_u64(Map* map, u64 key) {
+	if (map->len == 0) return;
+	u64 mask = map->cap - 1;
+	u64 i = hash_u64(key) & mask;
+	for (;;) {
+		if (!map->keys[i]) return;
+		if (map->keys[i] == key) break;
+		i = (i + 1) & mask;
+	}
+
+	/* shift the rest of the probe run back so no lookup stops at the hole */
+	u64 j = i;
+	for (;;) {
+		j = (j + 1) & mask;
+		if (!map->keys[j]) break;
+
+		u64 home = hash_u64(map->keys[j]) & mask;
+		bool home_in_gap = (i <= j ?
+							(i < home && home <= j) :
+							(i < home || home <= j));
+		if (!home_in_gap) {
+			map->keys[i] = map->keys[j];
+			map->vals[i] = map->vals[j];
+			i = j;
+		}
+	}
+	map->keys[i] = 0;
+	map->len--;
+}
+
+void map_remove(Map* map, const void* key) {
+	map_remove_u64(map, (u64)(uintptr_t)key);
+}
+
+void map_free(Map* map) {
+	free(map->keys);
+	free(map->vals);
+	map->keys = null;
+	map->vals = null;
+	map->len = 0;
+	map->cap = 0;
+}
+
+#define SHARED_MAP_MIN_CAP 64
+
+static void shared_map_grow(SharedMap* map) {
+	SharedTable* old_table = map->table;
+	u64 old_cap = (old_table ? old_table->cap : 0);
+	u64 cap = CLAMP_MIN(2 * old_cap, (map->min_cap ? map->min_cap : SHARED_MAP_MIN_CAP));
+	SharedTable* new_table = (SharedTable*)calloc(1, sizeof(SharedTable) + cap * sizeof(SharedEntry));
+	new_table->cap = cap;
+	u64 mask = cap - 1;
+	for (u64 i = 0; i < old_cap; i++) {
+		SharedEntry* entry = &old_table->entries[i];
+		if (!entry->key) continue;
+
+		u64 j = entry->hash & mask;
+		while (new_table->entries[j].key) {
+			j = (j + 1) & mask;
+		}
+		new_table->entries[j] = *entry;
+	}
+
+	__atomic_store_n(&map->table, new_table, __ATOMIC_RELEASE);
+	if (old_table) {
+		buf_push(map->retired, old_table);
+	}
+}
+
+/* the caller serializes writers and has found key absent, so the first
+ * empty slot of the probe run is where it goes */
+void shared_map_put(SharedMap* map, u64 hash, void* key, void* sub_key, void* val) {
+	assert(key);
+	if (!map->table || 2 * (map->len + 1) > map->table->cap) {
+		shared_map_grow(map);
+	}
+
+	SharedTable* table = map->table;
+	u64 mask = table->cap - 1;
+	u64 i = hash & mask;
+	while (table->entries[i].key) {
+		i = (i + 1) & mask;
+	}
+	SharedEntry* entry = &table->entries[i];
+	entry->sub_key = sub_key;
+	entry->val = val;
+	entry->hash = hash;
+	__atomic_store_n(&entry->key, key, __ATOMIC_RELEASE);
+	map->len++;
+}
+
+/* the live table and the retired ones; the caller serializes with writers */
+u64 shared_map_bytes(SharedMap* map) {
+	u64 bytes = 0;
+	if (map->table) {
+		bytes += sizeof(SharedTable) + map->table->cap * sizeof(SharedEntry);
+	}
+	buf_loop(map->retired, r) {
+		bytes += sizeof(SharedTable) + map->retired[r]->cap * sizeof(SharedEntry);
+	}
+	return bytes;
+}
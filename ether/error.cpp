@@ -1,7 +1,11 @@
 #include <ether.hpp>
 #include <error.hpp>
 
-void print_error_at(SourceFile* srcfile, u64 line, u64 column, u64 mark_len, const char* fmt, va_list ap) {
+void print_error_at(SourceFile* srcfile, u64 offset, u64 mark_len, const char* fmt, va_list ap) {
+	std::lock_guard<std::mutex> lock(output_mutex);
+	u64 line, column;
+	get_position_at(srcfile, offset, &line, &column);
+
 	va_list aq;
 	va_copy(aq, ap);
 	fprintf(stderr, "%s:%lu:%lu: error: ", 
@@ -16,7 +20,11 @@ void print_error_at(SourceFile* srcfile, u64 line, u64 column, u64 mark_len, con
 	print_marker_arrow_with_info_ln(srcfile, line, column, mark_len);
 }
 
-void print_warning_at(SourceFile* srcfile, u64 line, u64 column, u64 mark_len, const char* fmt, va_list ap) {
+void print_warning_at(SourceFile* srcfile, u64 offset, u64 mark_len, const char* fmt, va_list ap) {
+	std::lock_guard<std::mutex> lock(output_mutex);
+	u64 line, column;
+	get_position_at(srcfile, offset, &line, &column);
+
 	va_list aq;
 	va_copy(aq, ap);
 	fprintf(stderr, "%s:%lu:%lu: warning: ", 
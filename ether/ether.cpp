@@ -1,17 +1,33 @@
 #include <ether.hpp>
 #include <compiler.hpp>
 #include <data_type.hpp>
+#include <scan.hpp>
+#include <math.hpp>
+#include <profile.hpp>
+#include <stats.hpp>
 
+#include <getopt.h>
 #include <string>
+#include <thread>
 
 char* invoker_compiler = null;
+std::mutex output_mutex;
+bool threads_running = false;
 
 void ether_abort_no_args() {
+	/* the first thread to abort ends the process; any other thread that
+	 * fails meanwhile blocks here, or on its next diagnostic. _exit skips
+	 * the static destructors that other workers may still be using */
+	static std::mutex abort_mutex;
+	abort_mutex.lock();
+	output_mutex.lock();
 	fprintf(stderr, "Compilation terminated.\n");
-	exit(EXIT_FAILURE);
+	fflush(null);
+	_exit(EXIT_FAILURE);
 }
 
 void ether_print_error_va(const char* fmt, va_list ap) {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	va_list aq;
 	va_copy(aq, ap);
 	fprintf(stderr, "%s: ", invoker_compiler);
@@ -60,6 +76,26 @@ static void buf_test() {
 	assert(!buf_empty(literal));
 }
 
+/* long options without a short form get values past any char */
+enum LongOption {
+	OPT_TIME_REPORT = 256,
+	OPT_TRACE,
+	OPT_STATS,
+	OPT_PERF_COUNTERS,
+	OPT_MEM_REPORT,
+	OPT_CHECK_IR,
+};
+
+static struct option long_options[] = {
+	{ "time-report", no_argument, null, OPT_TIME_REPORT },
+	{ "trace", required_argument, null, OPT_TRACE },
+	{ "stats", optional_argument, null, OPT_STATS },
+	{ "perf-counters", no_argument, null, OPT_PERF_COUNTERS },
+	{ "mem-report", no_argument, null, OPT_MEM_REPORT },
+	{ "check-ir", no_argument, null, OPT_CHECK_IR },
+	{ null, 0, null, 0 },
+};
+
 int main(int argc, char** argv) {
 #ifdef _DEBUG
 	buf_test();
@@ -67,22 +103,91 @@ int main(int argc, char** argv) {
 	
 	char* output_exec_fpath = "a.out";
 	bool arg_parse_error = false;
+	u64 jobs = 1;
+	Backend backend = BACKEND_C;
 	int opt;
+
+	invoker_compiler = argv[0];
 	
-	while ((opt = getopt(argc, argv, "o:")) != -1) {
+	while ((opt = getopt_long(argc, argv, "o:j:b:", long_options, null)) != -1) {
 		switch (opt) {
 		case 'o': {
 			output_exec_fpath = optarg;
 		} break;
+
+		case 'j': {
+			/* -j 0 uses every available core */
+			char* end = null;
+			long n = strtol(optarg, &end, 10);
+			if (*end != '\0' || n < 0) {
+				ether_print_error("invalid job count ‘%s’;", optarg);
+				arg_parse_error = true;
+				break;
+			}
+			jobs = (n == 0 ? CLAMP_MIN(std::thread::hardware_concurrency(), 1u) : (u64)n);
+		} break;
 				
+		case 'b': {
+			/* nasm skips the C compiler, for quicker debug builds */
+			if (strcmp(optarg, "c") == 0) {
+				backend = BACKEND_C;
+			}
+			else if (strcmp(optarg, "nasm") == 0) {
+				backend = BACKEND_NASM;
+			}
+			else {
+				ether_print_error("unknown backend ‘%s’; expected ‘c’ or ‘nasm’;", optarg);
+				arg_parse_error = true;
+			}
+		} break;
+
+		case OPT_TIME_REPORT: {
+			profile_flags.time_report = true;
+		} break;
+
+		case OPT_TRACE: {
+			profile_flags.trace_fpath = optarg;
+		} break;
+
+		case OPT_PERF_COUNTERS: {
+			profile_flags.perf_counters = true;
+		} break;
+
+		case OPT_MEM_REPORT: {
+			/* buf growth comes from the stats counters */
+			profile_flags.mem_report = true;
+			stats_flags.counting = true;
+		} break;
+
+		case OPT_CHECK_IR: {
+			/* lowers every unit and checks the IR round trips through
+			 * its dump; nothing is written */
+			backend = BACKEND_CHECK_IR;
+		} break;
+
+		case OPT_STATS: {
+			/* --stats prints a table, --stats=json one JSON object */
+			stats_flags.enabled = true;
+			stats_flags.counting = true;
+			if (!optarg || strcmp(optarg, "text") == 0) {
+				stats_flags.format = STATS_TEXT;
+			}
+			else if (strcmp(optarg, "json") == 0) {
+				stats_flags.format = STATS_JSON;
+			}
+			else {
+				ether_print_error("unknown stats format ‘%s’; expected ‘text’ or ‘json’;", optarg);
+				arg_parse_error = true;
+			}
+		} break;
+
 		case '?': {
-			arg_parse_error = false;
+			/* getopt_long has printed what is wrong */
+			arg_parse_error = true;
 		} break;
 		}
 	}
 
-	invoker_compiler = argv[0];
-
 	if (arg_parse_error) {
 		ether_abort_no_args();
 	}
@@ -97,10 +202,24 @@ int main(int argc, char** argv) {
 	}
 
 	/* --- initialization --- */
+	sys_keywords_init();
+	sys_names_init();
+	sys_scanners_init();
 	sys_data_type_init();
+	profile_init();
 	
-	buf_loop(source_files, i) {		
-		Compiler compiler;
-		compiler.compile(source_files[i]);
-	}
+	Compiler compiler;
+	compiler.compile(source_files, jobs, backend);
+	profile_finish();
+	stats_report();
+	free_compile_units();
+
+#if PRINT_INTERN_STATS
+	u64 intern_count, intern_bytes, intern_blocks;
+	str_intern_stats(&intern_count, &intern_bytes, &intern_blocks);
+	fprintf(stderr, "interned strings: %lu (%lu bytes in %lu blocks)\n",
+			intern_count,
+			intern_bytes,
+			intern_blocks);
+#endif
 }
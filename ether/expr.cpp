@@ -2,5 +2,5 @@
 #include <token.hpp>
 
 u64 get_expr_char_count(Expr* expr) {
-	return expr->tail->end - expr->head->start;
+	return token_end(expr->tail) - expr->head->offset;
 }
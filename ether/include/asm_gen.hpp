@@ -0,0 +1,187 @@
+#pragma once
+
+#include <ether.hpp>
+#include <io.hpp>
+
+struct Stmt;
+struct Expr;
+struct DataType;
+struct Token;
+struct IrUnit;
+struct IrFunction;
+struct IrInstr;
+
+#define ASM_ARG_REG_COUNT 6
+#define ASM_NO_REG -1
+/* operands one emit can format at once */
+#define ASM_OPERAND_BUF_COUNT 4
+
+enum AsmReg {
+	ASM_RAX,
+	ASM_RCX,
+	ASM_RDX,
+	ASM_RBX,
+	ASM_RSI,
+	ASM_RDI,
+	ASM_R8,
+	ASM_R9,
+	ASM_R10,
+	ASM_R11,
+	ASM_R12,
+	ASM_R13,
+	ASM_R14,
+	ASM_R15,
+	ASM_RBP,
+	ASM_REG_COUNT,
+};
+
+struct StructLayout {
+	u64 size;
+	u64 align;
+	/* set while the fields are laid out, to catch a struct that
+	 * holds itself by value */
+	bool in_progress;
+};
+
+/* where an IR register's value lives */
+enum AsmValueKind {
+	ASM_VALUE_REG,
+	/* in the frame, at offset below rbp */
+	ASM_VALUE_SLOT,
+	/* a constant its only user takes as an immediate */
+	ASM_VALUE_IMM,
+	/* an address every user folds into its memory operand */
+	ASM_VALUE_ADDRESS,
+	/* a comparison the branch right after it reads from the flags */
+	ASM_VALUE_FLAGS,
+	/* nothing reads it; only a call producing it is emitted */
+	ASM_VALUE_UNUSED,
+};
+
+struct AsmValue {
+	AsmValueKind kind;
+	int reg;
+	u64 offset;
+	/* instructions are numbered in layout order */
+	u32 def;
+	/* the last instruction reading the value, itself or through a
+	 * folded address */
+	u32 last_use;
+	u32 use_count;
+	/* the last user, the only one when use_count is 1 */
+	u32 user;
+	/* set while every user can take it as a memory operand */
+	bool mem_only;
+	/* index registers its users add to the memory operand, which has
+	 * room for one */
+	u32 index_below;
+};
+
+/* a memory operand: [rel symbol + disp] or
+ * [base + index * scale + disp] */
+struct AsmAddress {
+	char* symbol;
+	int base;
+	int index;
+	u64 scale;
+	i64 disp;
+};
+
+/* emits a unit as NASM x86-64 assembly for the System V ABI, from its
+ * IR. types are laid out as C lays them out, so the code links
+ * against C and against units from the C backend. IR registers go to
+ * machine registers by linear scan, and to the frame when those run
+ * out */
+struct AsmGenerator {
+	Stmt** stmts;
+	char* output_fpath;
+
+	Writer writer;
+	/* struct lexeme -> Stmt* */
+	Map structs;
+	/* struct Stmt* -> StructLayout*, field Stmt* -> offset + 1 */
+	Map layouts;
+	Map field_offsets;
+
+	IrFunction* function;
+	AsmValue* values;
+	/* distance below rbp of each local */
+	u64* local_offsets;
+	/* clobbers[n] counts the instructions before n that clobber the
+	 * caller-saved registers */
+	u32* clobbers;
+	u64 frame_size;
+	/* bit n is set when callee-saved register n is used */
+	u32 saved_regs;
+	u64 block_label;
+	u64 return_label;
+	bool float_reported;
+	char operand_bufs[ASM_OPERAND_BUF_COUNT][96];
+	u32 operand_buf;
+
+	u64 label_count;
+	char** strings;
+	u64 error_count;
+
+	error_code generate(Stmt** _stmts, IrUnit* unit, char* _output_fpath);
+
+private:
+	void gen_globals();
+	void gen_global_var_decl(Stmt* stmt);
+	bool gen_constant(Expr* expr, u64 size);
+	void gen_strings();
+
+	void gen_function(IrFunction* _function);
+	void check_function();
+	void choose_kinds();
+	void choose_kind(u32 pos);
+	void note_use(IrInstr* instr, u32 reg);
+	bool can_take_imm(IrInstr* instr, u32 reg, u64 imm);
+	bool is_imm_operand(u32 reg);
+	void compute_liveness();
+	void mark_use(u32 reg, u32 pos);
+	void alloc_regs();
+	void layout_frame();
+	void gen_instr(u32 pos, u32 next_block);
+	void gen_binary(IrInstr* instr);
+	void gen_compare(IrInstr* instr);
+	void gen_call(IrInstr* instr);
+	void gen_branch(IrInstr* instr, u32 next_block);
+	void gen_return(IrInstr* instr, u32 pos);
+
+	const char* value_operand(u32 reg);
+	int value_in_reg(u32 reg, int scratch);
+	int dst_reg(u32 reg);
+	void finish_dst(u32 reg, int machine_reg);
+	void compose_address(IrInstr* instr, AsmAddress* address);
+	void compose_value_address(u32 reg, AsmAddress* address);
+	const char* address_operand(AsmAddress* address);
+	const char* mem_operand(u32 reg);
+	char* next_operand_buf();
+
+	const char* reg_name(int reg, u64 size);
+	void gen_load(int reg, const char* mem, DataType* data_type);
+	void gen_normalize(int reg, DataType* data_type);
+
+	StructLayout* layout_of(Stmt* stmt);
+	Stmt* struct_of(DataType* data_type);
+	u64 field_offset(Stmt* field, DataType* struct_type);
+	u64 type_size(DataType* data_type);
+	u64 type_align(DataType* data_type);
+	bool type_is_signed(DataType* data_type);
+	bool type_is_float(DataType* data_type);
+	bool type_is_aggregate(DataType* data_type);
+	bool is_local_function(Stmt* stmt);
+	char* func_symbol(Stmt* stmt);
+	u64 new_label();
+
+	void emit(const char* fmt, ...);
+	void emit_label(const char* fmt, ...);
+	void emit_raw(const char* fmt, ...);
+
+public:
+	void error_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap);
+	void warning_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap);
+};
+
+error_code run_assembler(char* asm_fpath, char* obj_fpath);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <ether.hpp>
+
+enum AstNodeKind {
+	AST_STMT,
+	AST_EXPR,
+	AST_DATA_TYPE,
+	AST_TOKEN,
+	AST_IF_BRANCH,
+	AST_SWITCH_BRANCH,
+	_AST_NODE_KIND_COUNT,
+};
+
+/* every node of one compilation unit is bump-allocated from its
+ * AstArena and released with it in ast_arena_free */
+struct AstArena {
+	Arena arena;
+	u64 node_counts[_AST_NODE_KIND_COUNT];
+	u64 node_bytes[_AST_NODE_KIND_COUNT];
+};
+
+void* ast_alloc(AstArena* ast_arena, AstNodeKind kind, u64 size);
+void ast_arena_free(AstArena* ast_arena);
+void ast_arena_print_stats(AstArena* ast_arena, const char* fpath);
+
+/* memory is zeroed, so nodes start out with null children */
+#define AST_NEW(ast_arena, kind, type) ((type*)ast_alloc((ast_arena), (kind), sizeof(type)))
@@ -1,27 +1,67 @@
 #pragma once
 
 #include <ether.hpp>
+#include <io.hpp>
 
 struct Stmt;
+struct Expr;
 struct DataType;
 struct Token;
+struct IrUnit;
+struct IrFunction;
+struct IrInstr;
 
+/* emits a unit as one C file: the prelude, every struct, the globals,
+ * a prototype for every function and then the function bodies, so
+ * nothing depends on the order of declarations in the source. bodies
+ * come from the IR, a C variable per register and a label per block */
 struct CodeGenerator {
 	Stmt** stmts;
-	char* obj_fpath;
-	
-	char* output_code;
+	IrUnit* ir;
+	char* output_fpath;
+
+	Writer writer;
 	u64 tab_count;
-	
-	void generate(Stmt** _stmts, char* _obj_fpath);
+	/* struct lexeme -> Stmt*, and the structs already emitted; a struct
+	 * is emitted after the ones its fields hold by value */
+	Map structs;
+	Map structs_emitted;
+	IrFunction* function;
+	/* per block, set when a jump to it does not fall through */
+	bool* block_labeled;
+
+	error_code generate(Stmt** _stmts, IrUnit* _ir, char* _output_fpath);
 
 private:
-	void gen_stmt(Stmt* stmt);
+	void gen_prelude();
 	void gen_struct(Stmt* stmt);
-	void gen_var_decl(Stmt* stmt);
+	void gen_global_var_decl(Stmt* stmt);
+	void gen_func_header(Stmt* stmt);
+	void gen_function(IrFunction* _function);
+	void gen_instr(IrInstr* instr, u32 next_block);
+	void gen_jump(u32 block, u32 next_block);
+	void gen_call(IrInstr* instr);
+
 	void gen_expr(Expr* expr);
+	void gen_binary_expr(Expr* expr);
+	void gen_unary_expr(Expr* expr);
+	void gen_cast_expr(Expr* expr);
+	void gen_func_call(Expr* expr);
+	void gen_array_access(Expr* expr);
+	void gen_member_access(Expr* expr);
+	void gen_number_expr(Expr* expr);
+	void gen_constant_expr(Expr* expr);
 
+	bool is_aggregate(DataType* data_type);
+	bool is_main(Stmt* stmt);
 	void print_data_type(DataType* data_type);
+	void print_type_name(DataType* data_type);
+	void print_var(DataType* data_type, char* name);
+	void print_func_name(Stmt* stmt);
+	void print_reg(u32 reg);
+	void print_local(u32 local);
+	void print_block(u32 block);
+	void print_u64(u64 n);
 	void print_tabs_by_indentation();
 	void print_newline();
 	void print_space();
@@ -31,3 +71,5 @@ private:
 	void print_string(char* str);
 	void print_char(char ch);
 };
+
+error_code run_c_compiler(char* c_fpath, char* obj_fpath);
@@ -1,12 +1,54 @@
 #pragma once
 
+#include <typedef.hpp>
+
 struct Stmt;
+struct Token;
+struct AstArena;
+struct SourceFile;
+struct ImportDecl;
+struct FileProfile;
 
-struct Compiler {
-	Stmt** compile(const char* in_file);
+enum CompileUnitVisit {
+	CUV_NOT_VISITED,
+	CUV_VISITING,
+	CUV_VISITED,
 };
 
-struct FileDecl {
+/* one source file, found on the command line or through an import.
+ * a unit's decls are spliced into every unit that imports it, so its
+ * tokens and AST are kept until free_compile_units at the end of the run */
+struct CompileUnit {
 	char* fpath;
+	char* canonical_fpath;
+	SourceFile* srcfile;
+
+	Token* tokens;
+	AstArena* ast_arena;
+	Stmt** stmts;
 	Stmt** decls;
+	ImportDecl* imports;
+	CompileUnit** import_units;
+
+	/* longest import chain below this unit; units of equal depth are
+	 * linked, resolved and generated together */
+	u64 depth;
+	CompileUnitVisit visit;
+
+	/* null unless --time-report or --trace is given */
+	FileProfile* profile;
 };
+
+/* what a unit is translated to before it becomes an object file */
+enum Backend {
+	BACKEND_C,
+	BACKEND_NASM,
+	/* only lowers to the IR and checks it, for --check-ir */
+	BACKEND_CHECK_IR,
+};
+
+struct Compiler {
+	void compile(char** fpaths, u64 jobs, Backend backend);
+};
+
+void free_compile_units();
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <typedef.hpp>
+#include <ds.hpp>
+#include <expr.hpp>
+#include <token.hpp>
+
+struct Stmt;
+struct IfBranch;
+struct DataType;
+struct AstArena;
+struct SourceFile;
+
+enum ConstKind {
+	CK_NONE,
+	CK_INT,
+	CK_FLOAT,
+	CK_BOOL,
+};
+
+/* the value of a literal. an integer is kept truncated to its type and
+ * sign or zero extended back to 64 bits, a bool is 0 or 1 */
+struct ConstValue {
+	ConstKind kind;
+	u64 i;
+	f64 f;
+};
+
+/* runs after resolve and rewrites constant subexpressions of the unit
+ * in place: a folded expression becomes a number, char or bool literal
+ * of the type resolve gave it, and keeps its source range. a local
+ * declared with ‘::’ that is never assigned and never has its address
+ * taken reads as the literal its initializer folds to */
+struct ConstantFolder {
+	Stmt** stmts;
+	AstArena* ast_arena;
+	/* local Stmt* -> the literal Expr* it was initialized with */
+	Map constants;
+	/* local Stmt* -> itself, for locals the function writes */
+	Map written;
+
+	u64 error_count;
+
+	error_code fold(Stmt** _stmts, AstArena* _ast_arena);
+
+private:
+	void fold_func_decl(Stmt* stmt);
+	void find_written_stmt(Stmt* stmt);
+	void find_written_expr(Expr* expr);
+
+	void fold_body(Stmt** body);
+	void fold_stmt(Stmt* stmt);
+	void fold_var_decl(Stmt* stmt);
+	void fold_if_branch(IfBranch* branch);
+
+	void fold_expr(Expr* expr);
+	void fold_binary_expr(Expr* expr);
+	void fold_arithmetic_expr(Expr* expr, ConstValue left, ConstValue right);
+	void fold_comparison_expr(Expr* expr, ConstValue left, ConstValue right);
+	void fold_bitshift_expr(Expr* expr, ConstValue left, ConstValue right);
+	void fold_logic_binary_expr(Expr* expr);
+	void fold_unary_expr(Expr* expr);
+	void fold_cast_expr(Expr* expr);
+	void fold_variable_ref(Expr* expr);
+
+	void make_int(Expr* expr, u64 value);
+	void make_float(Expr* expr, f64 value);
+	void make_bool(Expr* expr, bool value);
+	void make_literal(Expr* expr, ExprType type, char* lexeme, TokenType token_type);
+
+public:
+	void error_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap);
+	void warning_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap);
+};
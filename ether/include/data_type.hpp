@@ -5,13 +5,25 @@
 #define _DT_INTEGER_TYPE_COUNT 10
 
 struct Token;
+struct AstArena;
 
+enum DataTypeFlags {
+	DT_FLAG_INTEGER = 1 << 0,
+};
+
+/* a type as written in the source. identifier and start locate it for
+ * diagnostics; canonical is the one shared DataType with the same
+ * name, pointer count and array size, so two types are equal exactly
+ * when their canonical pointers are. a canonical type is its own
+ * canonical and has no source location */
 struct DataType {
 	Token* identifier;
 	u8 pointer_count;
 	bool is_array;
+	u8 flags;
 	Token* array_elem_count;
 	Token* start;
+	DataType* canonical;
 };
 
 enum DataTypeMatch {
@@ -21,11 +33,13 @@ enum DataTypeMatch {
 
 void sys_data_type_init();
 
-DataType* data_type_create(Token* identifier, u8 pointer_count, bool is_array, Token* array_elem_count, Token* start);
-DataType* data_type_from_string(char* type);
-DataType* data_type_from_string_int(char* type, u8 pointer_count);
+DataType* data_type_canonical(char* identifier, u8 pointer_count, bool is_array, char* array_elem_count);
+DataType* data_type_create(AstArena* ast_arena, Token* identifier, u8 pointer_count, bool is_array, Token* array_elem_count, Token* start);
+DataType* data_type_from_string(AstArena* ast_arena, char* type);
 
 DataTypeMatch data_type_integer(DataType* data_type);
+char* data_type_to_string(DataType* data_type);
+void data_type_memory(u64* canonical_bytes, u64* string_bytes);
 DataTypeMatch data_type_match(DataType* a, DataType* b);
 
 struct PredefinedDataTypes {
@@ -50,6 +64,7 @@ struct PredefinedDataTypes {
 	DataType* t_void_pointer;
 	DataType* t_f32;
 	DataType* t_f64;
+	DataType* t_void;
 };
 
 extern PredefinedDataTypes data_types;
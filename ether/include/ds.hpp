@@ -25,7 +25,7 @@ typedef struct BufHdr BufHdr;
 							((b) = buf__grow((b), (n), sizeof(*(b)))))
 #define buf_push(b, ...)   (buf_fit((b), 1 + buf_len(b)), \
 							(b)[buf__hdr(b)->len++] = (__VA_ARGS__))
-#define buf_pop(b)		   ((b) ? buf__shrink((b), 1) : 0)
+#define buf_pop(b)		   ((b) ? buf__shrink((b), 1) : (void)0)
 #define buf_printf(b, ...) ((b) = buf__printf((b), __VA_ARGS__))
 #define buf_clear(b)	   ((b) ? buf__hdr(b)->len = 0 : 0)
 #define buf_empty(b)	   ((b) ? (buf_len(b) == 0 ? true : false) : 0)
@@ -45,3 +45,118 @@ static T* buf__grow(T* buf, u64 new_len, u64 elem_size) {
 #endif
 
 void buf__shrink(const void* buf, u64 size);
+char* buf__printf(char* buf, const char* fmt, ...);
+
+#define ALIGN_DOWN(n, a) ((n) & ~((a) - 1))
+#define ALIGN_UP(n, a) ALIGN_DOWN((n) + (a) - 1, (a))
+#define ALIGN_DOWN_PTR(p, a) ((void*)ALIGN_DOWN((uintptr_t)(p), (a)))
+#define ALIGN_UP_PTR(p, a) ((void*)ALIGN_UP((uintptr_t)(p), (a)))
+
+#define ARENA_ALIGNMENT 8
+#define ARENA_BLOCK_SIZE (1024 * 1024)
+
+/* bump allocator; memory is only ever released all at once by arena_free */
+struct Arena {
+	char* ptr;
+	char* end;
+	char** blocks;
+
+	u64 alloc_count;
+	u64 bytes_allocated;
+};
+
+#ifndef __cplusplus
+typedef struct Arena Arena;
+#endif
+
+void* arena_alloc_aligned(Arena* arena, u64 size, u64 align);
+void* arena_alloc(Arena* arena, u64 size);
+void arena_free(Arena* arena);
+
+u64 hash_u64(u64 x);
+u64 hash_ptr(const void* ptr);
+u64 hash_bytes(const void* ptr, u64 len);
+
+/* open-addressing hash map with linear probing; cap is always a power
+ * of 2. key 0 marks an empty slot and a missing key reads as 0, so
+ * neither can be stored. a zeroed Map is an empty map */
+struct Map {
+	u64* keys;
+	u64* vals;
+	u64 len;
+	u64 cap;
+};
+
+#ifndef __cplusplus
+typedef struct Map Map;
+#endif
+
+u64 map_get_u64_from_u64(Map* map, u64 key);
+void map_put_u64_from_u64(Map* map, u64 key, u64 val);
+void* map_get(Map* map, const void* key);
+void map_put(Map* map, const void* key, void* val);
+void map_remove_u64(Map* map, u64 key);
+void map_remove(Map* map, const void* key);
+void map_free(Map* map);
+
+/* open-addressing table that threads probe without locking, while
+ * writers are serialized by the caller; cap is always a power of 2 and
+ * the entries follow the header. an entry is published by a release
+ * store of its key, and a grown table by a release store of the map's
+ * table pointer. key null marks an empty slot. a zeroed SharedMap is
+ * an empty map */
+struct SharedEntry {
+	void* key;
+	void* sub_key;
+	void* val;
+	u64 hash;
+};
+
+struct SharedTable {
+	u64 cap;
+	SharedEntry entries[];
+};
+
+struct SharedMap {
+	SharedTable* table;
+	u64 len;
+	/* cap of the first table; 0 for SHARED_MAP_MIN_CAP */
+	u64 min_cap;
+	/* tables replaced by a grow are kept, since readers may still be
+	 * probing them; together they are smaller than the live one */
+	SharedTable** retired;
+};
+
+#ifndef __cplusplus
+typedef struct SharedEntry SharedEntry;
+typedef struct SharedTable SharedTable;
+typedef struct SharedMap SharedMap;
+#endif
+
+/* the table to probe, null while the map is empty */
+inline SharedTable* shared_map_table(SharedMap* map) {
+	return __atomic_load_n(&map->table, __ATOMIC_ACQUIRE);
+}
+
+/* the entry with hash that match(key, entry) accepts, or null; counts
+ * the other entries it passed into *collisions. inlined, since nearly
+ * every lookup is a hit that does nothing but this probe */
+template <class Match>
+inline __attribute__((always_inline)) SharedEntry* shared_table_find(SharedTable* table, u64 hash, u64* collisions, Match match) {
+	u64 mask = table->cap - 1;
+	*collisions = 0;
+	for (u64 i = hash & mask;; i = (i + 1) & mask) {
+		SharedEntry* entry = &table->entries[i];
+		void* key = __atomic_load_n(&entry->key, __ATOMIC_ACQUIRE);
+		if (!key) {
+			return null;
+		}
+		if (entry->hash == hash && match(key, entry)) {
+			return entry;
+		}
+		(*collisions)++;
+	}
+}
+
+void shared_map_put(SharedMap* map, u64 hash, void* key, void* sub_key, void* val);
+u64 shared_map_bytes(SharedMap* map);
@@ -13,9 +13,8 @@ void error_expr(T* ins, Expr* expr, const char* fmt, ...) {
 	va_list ap;
 	va_start(ap, fmt);
 	error_root(ins,
-		 expr->head->file,
-		 expr->head->line,
-		 expr->head->column,
+		 token_file(expr->head),
+		 expr->head->offset,
 		 char_count,
 		 fmt,
 		 ap);
@@ -25,13 +24,12 @@ void error_expr(T* ins, Expr* expr, const char* fmt, ...) {
 template <typename T>
 void error_data_type(T* ins, DataType* data_type, const char* fmt, ...) {
 	assert(data_type);
-	u64 char_count = data_type->identifier->end - data_type->start->start;
+	u64 char_count = token_end(data_type->identifier) - data_type->start->offset;
 	va_list ap;
 	va_start(ap, fmt);
 	error_root(ins,
-		 data_type->identifier->file,
-		 data_type->identifier->line,
-		 data_type->identifier->column,
+		 token_file(data_type->identifier),
+		 data_type->identifier->offset,
 		 char_count,
 		 fmt,
 		 ap);
@@ -40,13 +38,12 @@ void error_data_type(T* ins, DataType* data_type, const char* fmt, ...) {
 
 template <typename T>
 void error_token(T* ins, Token* token, const char* fmt, ...) {
-	u64 char_count = token->end - token->start;
+	u64 char_count = token->char_count;
 	va_list ap;
 	va_start(ap, fmt);
 	error_root(ins,
-		 token->file,
-		 token->line,
-		 token->column,
+		 token_file(token),
+		 token->offset,
 		 char_count,
 		 fmt,
 		 ap);
@@ -54,10 +51,9 @@ void error_token(T* ins, Token* token, const char* fmt, ...) {
 }
 
 template <typename T>
-static void error_root(T* ins, SourceFile* srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap) {
+static void error_root(T* ins, SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
 	ins->error_root(srcfile,
-					line,
-					column,
+					offset,
 					char_count,
 					fmt,
 					ap);
@@ -69,9 +65,8 @@ void warning_expr(T* ins, Expr* expr, const char* fmt, ...) {
 	va_list ap;
 	va_start(ap, fmt);
 	warning_root(ins,
-		 expr->head->file,
-		 expr->head->line,
-		 expr->head->column,
+		 token_file(expr->head),
+		 expr->head->offset,
 		 char_count,
 		 fmt,
 		 ap);
@@ -81,13 +76,12 @@ void warning_expr(T* ins, Expr* expr, const char* fmt, ...) {
 template <typename T>
 void warning_data_type(T* ins, DataType* data_type, const char* fmt, ...) {
 	assert(data_type);
-	u64 char_count = data_type->identifier->end - data_type->start->start;
+	u64 char_count = token_end(data_type->identifier) - data_type->start->offset;
 	va_list ap;
 	va_start(ap, fmt);
 	warning_root(ins,
-		 data_type->identifier->file,
-		 data_type->identifier->line,
-		 data_type->identifier->column,
+		 token_file(data_type->identifier),
+		 data_type->identifier->offset,
 		 char_count,
 		 fmt,
 		 ap);
@@ -96,13 +90,12 @@ void warning_data_type(T* ins, DataType* data_type, const char* fmt, ...) {
 
 template <typename T>
 void warning_token(T* ins, Token* token, const char* fmt, ...) {
-	u64 char_count = token->end - token->start;
+	u64 char_count = token->char_count;
 	va_list ap;
 	va_start(ap, fmt);
 	warning_root(ins,
-		 token->file,
-		 token->line,
-		 token->column,
+		 token_file(token),
+		 token->offset,
 		 char_count,
 		 fmt,
 		 ap);
@@ -110,17 +103,16 @@ void warning_token(T* ins, Token* token, const char* fmt, ...) {
 }
 
 template <typename T>
-static void warning_root(T* ins, SourceFile* srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap) {
+static void warning_root(T* ins, SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
 	ins->warning_root(srcfile,
-					line,
-					column,
+					offset,
 					char_count,
 					fmt,
 					ap);
 }
 
-void print_error_at(SourceFile* srcfile, u64 line, u64 column, u64 mark_len, const char* fmt, va_list ap);
-void print_warning_at(SourceFile* srcfile, u64 line, u64 column, u64 mark_len, const char* fmt, va_list ap);
+void print_error_at(SourceFile* srcfile, u64 offset, u64 mark_len, const char* fmt, va_list ap);
+void print_warning_at(SourceFile* srcfile, u64 offset, u64 mark_len, const char* fmt, va_list ap);
 
 #define error_expr(e, fmt, ...) error_expr(this, e, fmt, ##__VA_ARGS__)
 #define error_data_type(d, fmt, ...) error_data_type(this, d, fmt, ##__VA_ARGS__)
@@ -13,6 +13,8 @@
 #include <ctype.h>
 #include <unistd.h>
 
+#include <mutex>
+
 #include <common.hpp>
 #include <ds.hpp>
 #include <error.hpp>
@@ -29,9 +31,48 @@
 
 #define PRINT_TOKEN 0
 #define PRINT_AST 1
+#define PRINT_IR 0
+#define PRINT_INTERN_STATS 0
+#define PRINT_AST_STATS 0
+
+#define LEXER_SIMD 1
+#define SOURCE_FILE_MMAP 1
+
+/* the generated C of every unit is compiled to an object file with
+ * this compiler, unless $CC names another */
+#define C_COMPILER "cc"
+#define C_COMPILER_OPT_LEVEL "-O2"
+
+/* assembles the output of the nasm backend (-b nasm) */
+#define ASSEMBLER "nasm"
+
+/* held while printing anything that must not interleave with output
+ * from units compiling on other threads */
+extern std::mutex output_mutex;
+
+/* set while units compile on more than one thread; until then the
+ * interner inserts without taking its locks */
+extern bool threads_running;
 
 void ether_abort(const char* fmt, ...);
+void ether_print_error(const char* fmt, ...);
 void ether_abort_no_args();
+void sys_keywords_init();
+void sys_names_init();
 
 extern char* keywords[KEYWORDS_LEN];
 extern char* built_in_types[BUILT_IN_TYPES_LEN];
+
+/* names the compiler checks identifiers against. like keywords and
+ * built_in_types they are interned by sys_names_init, and since every
+ * token lexeme is interned too, comparing against them is a pointer
+ * compare */
+struct WellKnownNames {
+	char* main;
+	char* void_type;
+	char* eof;
+};
+
+extern WellKnownNames names;
+
+bool is_built_in_type(char* lexeme);
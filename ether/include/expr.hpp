@@ -26,10 +26,16 @@ struct Expr {
 	ExprType type;
 	Token* head;
 	Token* tail;
+	/* type of the value, set by resolve */
+	DataType* data_type;
 	union {
 		struct {
 			Token* identifier;
 			Stmt* variable_refed;
+			/* set by the linker: depth of the declaring scope (0 is
+			 * global) and the variable's index within that scope */
+			u32 depth;
+			u32 slot;
 		} variable_ref;
 
 		struct {
@@ -46,6 +52,7 @@ struct Expr {
 		struct {
 			Expr* left;
 			Token* right;
+			Stmt* field; // set by resolve
 		} member_access;
 		
 		struct {
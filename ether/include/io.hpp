@@ -1,16 +1,57 @@
 #pragma once
 
+#define SOURCE_FILE_NONE 0
+
+/* contents[len, len + SOURCE_FILE_PADDING) is always readable and zero,
+ * so scanners can load whole vectors and stop on the '\0' sentinel */
+#define SOURCE_FILE_PADDING 64
+
 struct SourceFile {
 	char* fpath;
 	char* contents;
-	uint len;
+	u64 len;
+	u16 id;
+	/* size of the mapping when contents is mmap'd, 0 when malloc'd */
+	u64 map_len;
+	/* offset of the first byte of every line; line n starts at
+	 * line_starts[n - 1]. built by build_line_table() */
+	u64* line_starts;
+};
+
+#define WRITER_BUFFER_SIZE (64 * 1024)
+
+/* buffered output file. everything goes to a temporary file beside
+ * fpath, which replaces fpath only in writer_commit, so a failed
+ * compile never leaves a truncated output behind */
+struct Writer {
+	char* fpath;
+	char* tmp_fpath;
+	int fd;
+	char* buf;
+	u64 len;
+	/* errno of the first failed write, 0 if none */
+	int error;
 };
 
 SourceFile* read_file(const char* fpath);
+SourceFile* source_file_from_id(u16 id);
+void free_file(SourceFile* file);
 bool file_exists(const char* fpath);
+char* canonicalize_fpath(const char* fpath);
+void build_line_table(SourceFile* file);
+void get_position_at(SourceFile* file, u64 offset, u64* line, u64* column);
 char* get_line_at(SourceFile* file, u64 line);
 error_code print_file_line(SourceFile* file, u64 line);
 error_code print_file_line_with_info(SourceFile* file, u64 line);
 error_code print_marker_arrow_ln(SourceFile* file, u64 line, u64 column, u64 mark_len);
 error_code print_marker_arrow_with_info_ln(SourceFile* file, u64 line, u64 column, u64 mark_len);
 void print_tab(void);
+
+error_code writer_open(Writer* writer, char* fpath);
+void writer_write(Writer* writer, const char* data, u64 len);
+void writer_write_str(Writer* writer, const char* str);
+void writer_write_char(Writer* writer, char ch);
+error_code writer_commit(Writer* writer);
+void writer_discard(Writer* writer);
+
+error_code run_program(char** argv);
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <ether.hpp>
+
+struct Stmt;
+struct Expr;
+struct DataType;
+struct Token;
+
+/* a three-address IR, lowered from the resolved AST, that every
+ * backend generates from. every value lives in a virtual
+ * register, which one instruction defines and which has one type.
+ * structs and arrays are only handled by address, which for an array
+ * is a pointer to its first element. registers flow forward within a
+ * statement; values kept across a loop go through locals */
+#define IR_NO_REG UINT32_MAX
+
+enum IrOp {
+	IR_CONST,		/* dst = imm; a float constant holds a double's bits */
+	IR_STRING,		/* dst = address of the string literal str */
+	IR_GLOBAL,		/* dst = address of the global stmt */
+	IR_LOCAL,		/* dst = address of local imm */
+	IR_LOAD,		/* dst = *a */
+	IR_STORE,		/* *a = b */
+	IR_COPY,		/* copy the type-sized object at b to a */
+	IR_FIELD,		/* dst = address of field stmt of the struct at a */
+	IR_INDEX,		/* dst = address of element b of the array at a */
+
+	IR_ADD,
+	IR_SUB,
+	IR_MUL,
+	IR_DIV,
+	IR_MOD,
+	IR_AND,
+	IR_OR,
+	IR_SHL,
+	IR_SHR,
+	/* comparisons give bool; type is the operands' */
+	IR_EQ,
+	IR_NE,
+	IR_LT,
+	IR_LE,
+	IR_GT,
+	IR_GE,
+	IR_NEG,
+	IR_NOT,			/* bitwise */
+	IR_LNOT,		/* of a bool */
+	IR_CAST,		/* dst = a converted to type */
+
+	IR_CALL,		/* dst = call.function(args), dst is IR_NO_REG for void */
+	/* terminators, one at the end of every block */
+	IR_JUMP,		/* to target.then_block */
+	IR_BRANCH,		/* to target.then_block if a, else to target.else_block */
+	IR_RET,			/* a, or IR_NO_REG */
+	_IR_OP_COUNT,
+};
+
+/* type is the type the operation works on: the loaded or stored
+ * value, the operands of arithmetic and comparisons, the element of
+ * IR_INDEX, the field of IR_FIELD, the target of IR_CAST */
+struct IrInstr {
+	IrOp op;
+	u32 dst;
+	u32 a;
+	u32 b;
+	DataType* type;
+	/* the source the instruction comes from, for diagnostics */
+	Token* token;
+	union {
+		u64 imm;
+		char* str;
+		Stmt* stmt;
+		struct {
+			Stmt* function;
+			/* args[arg_start, arg_start + arg_count) of the function */
+			u32 arg_start;
+			u32 arg_count;
+		} call;
+		struct {
+			u32 then_block;
+			u32 else_block;
+		} target;
+	};
+};
+
+/* instrs[first, first + count) */
+struct IrBlock {
+	u32 first;
+	u32 count;
+};
+
+/* a stack object: a parameter, a local, the ‘this’ of a struct
+ * function, or a value the lowering keeps across blocks. name is null
+ * for the last */
+struct IrLocal {
+	DataType* type;
+	char* name;
+};
+
+/* locals[0, param_count) are the parameters, ‘this’ first, and start
+ * out holding the arguments. an array parameter is a pointer to its
+ * first element, as in C. blocks are indexed by id and laid out in
+ * block_order; instrs holds them in that order */
+struct IrFunction {
+	Stmt* decl;
+	u32 param_count;
+	IrLocal* locals;
+	DataType** reg_types;
+	IrInstr* instrs;
+	IrBlock* blocks;
+	u32* block_order;
+	u32* args;
+};
+
+struct IrUnit {
+	IrFunction* functions;
+};
+
+/* lowers every function with a body. the AST must be resolved */
+struct IrBuilder {
+	Stmt** stmts;
+	/* struct lexeme -> Stmt* */
+	Map structs;
+	/* canonical DataType* -> the type of its address, to keep
+	 * data_type_canonical off the path of every access */
+	Map addr_types;
+	IrUnit* unit;
+
+	IrFunction* function;
+	/* local Stmt* -> index + 1 */
+	Map locals;
+	u32 current_block;
+	/* set by a terminator; the next instruction opens a new, unreachable
+	 * block */
+	bool terminated;
+
+	IrUnit* build(Stmt** _stmts);
+
+private:
+	void build_function(Stmt* stmt);
+	u32 add_local(DataType* data_type, Token* identifier);
+	u32 new_reg(DataType* data_type);
+	u32 new_block();
+	void start_block(u32 block);
+	IrInstr* emit(IrOp op, DataType* data_type, Token* token);
+	u32 emit_value(IrOp op, DataType* reg_type, DataType* data_type, Token* token, u32 a, u32 b);
+	void emit_jump(u32 block, Token* token);
+	void emit_branch(u32 cond, u32 then_block, u32 else_block, Token* token);
+	u32 emit_local(u32 local, Token* token);
+	u32 emit_load_local(u32 local, Token* token);
+	void emit_store(u32 addr, u32 value, DataType* data_type, Token* token);
+
+	void build_stmt(Stmt* stmt);
+	void build_body(Stmt** body);
+	void build_var_decl(Stmt* stmt);
+	void build_if_stmt(Stmt* stmt);
+	void build_for_stmt(Stmt* stmt);
+	void build_switch_stmt(Stmt* stmt);
+	void build_return_stmt(Stmt* stmt);
+
+	u32 build_expr(Expr* expr);
+	u32 build_addr(Expr* expr);
+	u32 build_binary_expr(Expr* expr);
+	u32 build_logic_binary_expr(Expr* expr);
+	u32 build_assign_expr(Expr* expr);
+	u32 build_unary_expr(Expr* expr);
+	u32 build_func_call(Expr* expr);
+	u32 build_constant(Expr* expr);
+
+	bool is_aggregate(DataType* data_type);
+	DataType* addr_type(DataType* data_type);
+};
+
+void ir_free(IrUnit* unit);
+/* "Struct.name" for a struct function */
+char* ir_function_name(Stmt* stmt);
+const char* ir_op_name(IrOp op);
+u8 ir_char_value(char* lexeme);
+bool ir_is_terminator(IrOp op);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ether.hpp>
+#include <ir.hpp>
+
+/* reads the text IrPrinter writes back into an IrUnit. functions,
+ * globals and fields are named, so they are looked up in the
+ * statements the IR was built from */
+struct IrParser {
+	Stmt** stmts;
+	char* cursor;
+	u64 line;
+	bool failed;
+	/* "Struct.name" -> function Stmt*, lexeme -> global or struct Stmt* */
+	Map functions;
+	Map globals;
+	Map structs;
+	IrUnit* unit;
+	IrFunction* function;
+
+	/* text is null-terminated. returns null on malformed text */
+	IrUnit* parse(Stmt** _stmts, char* text);
+
+private:
+	void parse_function();
+	void parse_instr();
+	void parse_operands(IrInstr* instr);
+	DataType* parse_data_type();
+	u32 parse_reg();
+	u32 parse_block();
+	char* parse_name();
+	u64 parse_u64();
+	void expect(const char* str);
+	bool match(const char* str);
+	bool at_line_end();
+	void fail(const char* fmt, ...);
+};
+
+/* checks that every block ends in its only terminator and every
+ * operand is defined before it is used, and that the unit survives
+ * printing and parsing unchanged */
+bool ir_check(IrUnit* unit, Stmt** stmts);
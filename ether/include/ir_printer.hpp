@@ -0,0 +1,23 @@
+#pragma once
+
+#include <ether.hpp>
+#include <ir.hpp>
+
+/* renders a unit's IR as text, one instruction per line. IrParser
+ * reads the same text back */
+struct IrPrinter {
+	/* stretchy buffer, owned by the caller */
+	char* text;
+
+	char* print(IrUnit* unit);
+
+private:
+	void print_function(IrFunction* function);
+	void print_instr(IrFunction* function, IrInstr* instr);
+	void print_data_type(DataType* data_type);
+	void print_reg(u32 reg);
+	void print_block(u32 block);
+	void print_string(const char* str);
+	void print_char(char c);
+	void print_u64(u64 n);
+};
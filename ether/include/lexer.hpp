@@ -4,22 +4,19 @@
 #include <token.hpp>
 
 struct LexerOutput {
-	Token** tokens;
+	Token* tokens;
 	error_code error_occured;
 }; 
 
 struct Lexer {
 	SourceFile* srcfile;
 	
-	Token** tokens;
+	Token* tokens;
 	u64 error_count;
 
 	char* start;
 	char* current;
-	u64 line;
-
-	char* last_newline;
-	char* last_to_last_newline;
+	char* end;
 
 	LexerOutput lex(SourceFile* _srcfile);
 
@@ -28,7 +25,6 @@ private:
 	void number();
 	void string();
 	void chr();
-	void newline();
 
 	void escape_chars();
 	void backslash();
@@ -40,13 +36,12 @@ private:
 	void add_in(TokenType type);
 	void add_eof();
 
-	u64 compute_column();
-	u64 compute_column_on_current();
+	u64 compute_offset(char* c);
 
 	void error(const char* fmt, ...);
-	void error_at(u64 _line, u64 _column, const char* fmt, ...);
+	void error_at(char* c, const char* fmt, ...);
 
 	void warning(const char* fmt, ...);
-	void warning_at(u64 _line, u64 _column, const char* fmt, ...);
-	void warning_at_rng(u64 _line, u64 _column, u64 mark_len, const char* fmt, ...);
+	void warning_at(char* c, const char* fmt, ...);
+	void warning_at_rng(char* c, u64 mark_len, const char* fmt, ...);
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <typedef.hpp>
+#include <ds.hpp>
 
 struct Stmt;
 struct IfBranch;
@@ -9,11 +10,15 @@ struct SwitchBranch;
 struct StructFunctionMap {
 	Stmt* stmt;
 	Stmt** functions;
+	Map function_map;
 };
 
-struct Scope {
-	Scope* parent_scope;
-	Stmt** variables;
+struct ScopeVariable {
+	Stmt* stmt;
+	u64 depth;
+	u64 slot;
+	/* index + 1 of the variable this one shadows, 0 if none */
+	u64 shadowed;
 };
 
 enum VariableScope {
@@ -25,10 +30,16 @@ enum VariableScope {
 struct Linker {
 	Stmt** stmts;
 	
-	StructFunctionMap** defined_structs;
-	Stmt** defined_functions;
-	Scope* current_scope;
-	Scope* global_scope;
+	/* symbol tables keyed by the interned identifier lexeme */
+	Map defined_structs;	/* StructFunctionMap* */
+	Map defined_functions;	/* Stmt* */
+	/* scope stack: variables in declaration order, innermost last.
+	 * scope n (1 is the outermost local one) starts at
+	 * variables[scope_starts[n - 1]]; depth 0 holds the globals */
+	ScopeVariable* variables;
+	u64* scope_starts;
+	/* identifier lexeme -> index + 1 of its innermost variable */
+	Map variable_map;
 	Stmt* function_in;
 	u64 error_count;
 	
@@ -37,6 +48,7 @@ struct Linker {
 private:
 	void add_structs();
 	void add_struct(Stmt* stmt);
+	void free_structs();
 	void add_functions();
 	void add_function_global(Stmt* stmt);
 	void add_function_struct(Stmt* stmt);
@@ -62,13 +74,18 @@ private:
 	void check_cast_expr(Expr* expr);
 	void check_func_call(Expr* expr);
 	void check_array_access(Expr* expr);
+	void check_member_access(Expr* expr);
 	void check_variable_ref(Expr* expr);
 	void check_data_type(DataType* data_type, bool is_return_data_type);
 	void add_variable_to_scope(Stmt* stmt);
+	void push_variable(Stmt* stmt);
+	void enter_scope();
+	void exit_scope();
+	ScopeVariable* find_variable(Token* identifier);
 	VariableScope is_variable_ref_in_scope(Expr* expr);
 	VariableScope is_variable_in_scope(Stmt* stmt);
 	
 public:
-	void error_root(SourceFile* srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap);
-	void warning_root(SourceFile* srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap);
+	void error_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap);
+	void warning_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap);
 };
@@ -5,10 +5,20 @@
 #include <stmt.hpp>
 #include <expr.hpp>
 #include <data_type.hpp>
+#include <ast_arena.hpp>
+
+/* an #import directive; fpath is relative to the working directory
+ * like any path given on the command line */
+struct ImportDecl {
+	char* fpath;
+	char* canonical_fpath;
+	Token* token;
+};
 
 struct ParserOutput {
 	Stmt** stmts;
 	Stmt** decls;
+	ImportDecl* imports;
 	error_code error_occured;
 };
 
@@ -27,8 +37,9 @@ enum ParserErrorLocation {
 };
 
 struct Parser {
-	Token** tokens;
+	Token* tokens;
 	SourceFile* srcfile;
+	AstArena* ast_arena;
 
 	Stmt** stmts;
 	Stmt** decls;
@@ -44,10 +55,9 @@ struct Parser {
 	bool error_lbrace_parsed = false;
 
 	Stmt* current_struct;
-	char** pending_imports;
+	ImportDecl* imports;
 	
-	ParserOutput parse(Token** _tokens, SourceFile* _srcfile);
-	void add_pending_imports();
+	ParserOutput parse(Token* _tokens, SourceFile* _srcfile, AstArena* _ast_arena);
 
 private:
 	Stmt* decl_global();
@@ -96,7 +106,7 @@ private:
 	Expr* constant_create(Token* constant);
 	
 	bool match_identifier();
-	bool match_keyword(char* keyword);
+	bool match_keyword(KeywordType keyword);
 	bool match_by_type(TokenType type);
 	bool match_double_colon();
 	bool match_lparen();
@@ -109,6 +119,7 @@ private:
 	bool match_rangbkt();
 	bool match_semicolon();
 	DataType* match_data_type();
+	bool brackets_start_data_type();
 	void previous_data_type(DataType* data_type);
 	
 	Token* consume_identifier();
@@ -137,6 +148,6 @@ private:
 	void sync_to_next_statement();
 
 public:
-	void error_root(SourceFile* _srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap);
-	void warning_root(SourceFile* _srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap);
+	void error_root(SourceFile* _srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap);
+	void warning_root(SourceFile* _srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap);
 }; 
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <typedef.hpp>
+
+struct Stmt;
+
+/* the steps every compiled file goes through, in pipeline order.
+ * PHASE_IMPORTS is the bookkeeping between parse waves that finds
+ * imported files and orders them, and belongs to no file */
+enum ProfilePhase {
+	PHASE_READ,
+	PHASE_LEX,
+	PHASE_PARSE,
+	PHASE_IMPORTS,
+	PHASE_LINK,
+	PHASE_RESOLVE,
+	PHASE_FOLD,
+	PHASE_IR,
+	PHASE_CODE_GEN,
+	PHASE_BACKEND,
+	_PHASE_COUNT,
+};
+
+/* hardware and kernel counters of --perf-counters */
+enum PerfCounter {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_CACHE_MISSES,
+	PERF_BRANCH_MISSES,
+	PERF_PAGE_FAULTS,
+	_PERF_COUNTER_COUNT,
+};
+
+/* where --mem-report puts the bytes the compiler holds */
+enum MemorySubsystem {
+	MEM_TOKENS,
+	MEM_AST,
+	MEM_INTERN,
+	MEM_TYPES,
+	MEM_TYPE_STRINGS,
+	MEM_SCOPES,
+	MEM_BUFS,
+	_MEM_SUBSYSTEM_COUNT,
+};
+
+struct PhaseTime {
+	u64 wall_ns;
+	u64 cpu_ns;
+	u64 counters[_PERF_COUNTER_COUNT];
+	/* resident set growth over the phase, and the process's peak
+	 * resident set at its end */
+	u64 rss_grown;
+	u64 peak_rss;
+};
+
+/* the phases of one source file. a file is worked on by one thread at
+ * a time, so its times are added up without locking */
+struct FileProfile {
+	char* fpath;
+	PhaseTime phases[_PHASE_COUNT];
+};
+
+/* where a phase started; zero when nothing is profiled */
+struct ProfileMark {
+	u64 wall_ns;
+	u64 cpu_ns;
+	u64 counters[_PERF_COUNTER_COUNT];
+	u64 rss;
+};
+
+/* set from the command line, before profile_init */
+struct ProfileFlags {
+	bool time_report;
+	/* where --trace writes Chrome trace events, null if not given */
+	char* trace_fpath;
+	bool perf_counters;
+	bool mem_report;
+};
+
+extern ProfileFlags profile_flags;
+
+void profile_init();
+FileProfile* profile_file(char* fpath);
+void profile_thread(u64 worker);
+ProfileMark profile_begin();
+void profile_end(ProfileMark mark, ProfilePhase phase, FileProfile* file);
+void profile_file_end(ProfileMark mark, FileProfile* file);
+/* a top-level declaration going through a phase; only traced */
+ProfileMark profile_stmt_begin();
+void profile_stmt_end(ProfileMark mark, ProfilePhase phase, Stmt* stmt);
+void profile_memory(MemorySubsystem subsystem, u64 bytes);
+void profile_finish();
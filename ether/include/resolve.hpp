@@ -1,21 +1,26 @@
 #pragma once
 
 #include <typedef.hpp>
+#include <ds.hpp>
 
 struct Stmt;
 struct IfBranch;
 struct SwitchBranch;
+struct StructFunctionMap;
 
 struct Resolve {
 	Stmt** stmts;
+	/* struct lexeme -> StructFunctionMap* */
+	Map structs;
 
 	u64 error_count;
-	char** data_type_strings;
 
 	error_code resolve(Stmt** _stmts);
 
 private:
-	void destroy();
+	void add_structs();
+	void free_structs();
+	StructFunctionMap* struct_of(DataType* data_type);
 	
 	void resolve_stmt(Stmt* stmt);
 	void resolve_struct(Stmt* stmt);
@@ -24,11 +29,14 @@ private:
 	void resolve_if_stmt(Stmt* stmt);
 	void resolve_if_branch(IfBranch* branch);
 	void resolve_for_stmt(Stmt* stmt);
+	void resolve_switch_stmt(Stmt* stmt);
+	void resolve_return_stmt(Stmt* stmt);
 	void resolve_expr_stmt(Stmt* stmt);
 	void resolve_block(Stmt* stmt);
 	
 	DataType* resolve_expr(Expr* expr);
 	DataType* resolve_binary_expr(Expr* expr);
+	DataType* resolve_assign_expr(Expr* expr);
 	DataType* resolve_arithmetic_expr(Expr* expr);
 	DataType* resolve_logic_binary_expr(Expr* expr);
 	DataType* resolve_bitwise_binary_expr(Expr* expr);
@@ -43,9 +51,8 @@ private:
 	DataType* resolve_number_expr(Expr* expr);
 	DataType* resolve_constant_expr(Expr* expr);
 
-	char* data_type_to_string(DataType* data_type);
 
 public:
-	void error_root(SourceFile* srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap);
-	void warning_root(SourceFile* srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap);
+	void error_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap);
+	void warning_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap);
 };
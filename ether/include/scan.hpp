@@ -0,0 +1,80 @@
+#pragma once
+
+#include <typedef.hpp>
+
+enum CharClass {
+	CC_WHITESPACE = 1 << 0,
+	CC_IDENTIFIER = 1 << 1,
+	CC_DIGIT = 1 << 2,
+};
+
+struct CharClassTable {
+	u8 classes[256];
+};
+
+static constexpr CharClassTable char_class_table_generate() {
+	CharClassTable table = {};
+	for (u32 c = 0; c < 256; c++) {
+		u8 cls = 0;
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+			cls |= CC_WHITESPACE;
+		}
+		if ((c >= 'a' && c <= 'z') ||
+			(c >= 'A' && c <= 'Z') ||
+			(c >= '0' && c <= '9') ||
+			c == '_') {
+			cls |= CC_IDENTIFIER;
+		}
+		if (c >= '0' && c <= '9') {
+			cls |= CC_DIGIT;
+		}
+		table.classes[c] = cls;
+	}
+	return table;
+}
+
+static constexpr CharClassTable char_classes = char_class_table_generate();
+
+inline bool is_char_class(char c, u8 cls) {
+	return (char_classes.classes[(u8)c] & cls) != 0;
+}
+
+/* each scanner returns the first position at or after c that does not
+ * belong to the run. no run includes '\0', so the zeroed SourceFile
+ * padding ends every run without a bounds check; wide paths are
+ * selected once at startup */
+struct Scanners {
+	char* (*skip_whitespace)(char* c);
+	char* (*skip_identifier)(char* c);
+	char* (*skip_string_body)(char* c);
+	const char* name;
+};
+
+extern Scanners scanners;
+
+void sys_scanners_init();
+
+/* most runs are only a few bytes long, so a short scalar prefix is
+ * checked inline before handing the rest to the wide scanner */
+#define SCAN_SCALAR_PREFIX 8
+
+inline char* skip_whitespace(char* c) {
+	for (u64 i = 0; i < SCAN_SCALAR_PREFIX; i++, c++) {
+		if (!is_char_class(*c, CC_WHITESPACE)) return c;
+	}
+	return scanners.skip_whitespace(c);
+}
+
+inline char* skip_identifier(char* c) {
+	for (u64 i = 0; i < SCAN_SCALAR_PREFIX; i++, c++) {
+		if (!is_char_class(*c, CC_IDENTIFIER)) return c;
+	}
+	return scanners.skip_identifier(c);
+}
+
+inline char* skip_string_body(char* c) {
+	for (u64 i = 0; i < SCAN_SCALAR_PREFIX; i++, c++) {
+		if (*c == '"' || *c == '\0') return c;
+	}
+	return scanners.skip_string_body(c);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <typedef.hpp>
+
+struct Stmt;
+struct Token;
+
+/* events counted in the data structures every phase leans on */
+enum StatCounter {
+	STAT_INTERN_LOOKUPS,
+	STAT_INTERN_HITS,
+	/* occupied slots probed past before the string or an empty slot */
+	STAT_INTERN_COLLISIONS,
+	STAT_BUF_GROWS,
+	/* what a grow of a non-empty buffer has to carry over */
+	STAT_BUF_BYTES_COPIED,
+	/* capacity added by grows, in bytes */
+	STAT_BUF_BYTES_GROWN,
+	STAT_SCOPE_LOOKUPS,
+	STAT_SCOPE_MISSES,
+	/* scopes between a variable reference and its declaration */
+	STAT_SCOPE_DEPTH,
+	STAT_DATA_TYPE_MATCHES,
+	_STAT_COUNT,
+};
+
+enum StatsFormat {
+	STATS_TEXT,
+	STATS_JSON,
+};
+
+/* set from the command line, before anything is compiled */
+struct StatsFlags {
+	bool enabled;
+	StatsFormat format;
+	/* counters are kept: for --stats, or for --mem-report, which reads
+	 * some of them */
+	bool counting;
+};
+
+extern StatsFlags stats_flags;
+
+void stats_add_slow(StatCounter counter, u64 n);
+
+/* without --stats a count is a single load and branch */
+#define STAT_ADD(counter, n) (stats_flags.counting ? stats_add_slow((counter), (n)) : (void)0)
+#define STAT_INC(counter) STAT_ADD((counter), 1)
+
+u64 stats_total(StatCounter counter);
+void stats_count_tokens(Token* tokens);
+void stats_count_ast(Stmt** stmts);
+void stats_report();
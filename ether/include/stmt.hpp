@@ -44,6 +44,9 @@ struct Stmt {
 			DataType* data_type;
 			Expr* initializer;
 			bool is_variable;
+			/* global variables: the copy other units import, which
+			 * gets the type resolve infers for this one */
+			Stmt* decl;
 		} var_decl;
 
 		struct {
@@ -1,9 +1,6 @@
 #pragma once
 
-struct StrIntern {
-	char* str;
-	u64 len;
-};
-
 char* str_intern_range(char* start, char* end);
 char* str_intern(char* str);
+void str_intern_stats(u64* count, u64* bytes, u64* blocks);
+u64 str_intern_table_bytes();
@@ -61,19 +61,41 @@ enum TokenType {
 	T_EOF,
 };
 
+enum KeywordType {
+	KW_NONE = -1,
+	KW_IMPORT,
+	KW_STRUCT,
+	KW_EXTERN,
+	KW_PUB,
+	KW_IF,
+	KW_ELIF,
+	KW_ELSE,
+	KW_FOR,
+	KW_SWITCH,
+	KW_RETURN,
+	KW_CAST,
+	KW_TRUE,
+	KW_FALSE,
+	KW_NULL,
+};
+
 struct SourceFile;
+struct AstArena;
 
+/* tokens are stored by value in one buffer per file; line and column
+ * are derived from the offset only when a diagnostic needs them */
 struct Token {
 	char* lexeme;
-	char* start;
-	char* end;
-	TokenType type;
-	SourceFile* file;
-	u64 line;
-	u64 column;
-	u64 char_count;
-}; 
+	u64 offset;
+	u32 char_count;
+	u16 file_id;
+	TokenType type : 8;
+	KeywordType keyword : 8;
+};
 
-Token* token_create(char* lexeme, char* start, char* end, TokenType type, SourceFile* file, u64 line, u64 column, u64 char_count);
+Token* token_create(AstArena* ast_arena, char* lexeme, u64 offset, u32 char_count, TokenType type, u16 file_id);
+SourceFile* token_file(Token* token);
+u64 token_end(Token* token);
 bool is_token_equal(Token* a, Token* b);
-Token* token_from_string(char* lexeme);
+Token* token_from_string(AstArena* ast_arena, char* lexeme);
+KeywordType keyword_lookup(char* lexeme, u64 len);
@@ -1,48 +1,185 @@
 #include <ether.hpp>
 #include <io.hpp>
 
+#include <atomic>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+/* index 0 is SOURCE_FILE_NONE, for tokens that have no backing file.
+ * the array never moves, so lookups by id need no lock; only handing
+ * out ids is serialized */
+static SourceFile* source_files[UINT16_MAX + 1];
+static u64 source_files_len = 1;
+static std::mutex source_files_mutex;
+
+static char* read_fd_padded(int fd, u64* len) {
+	u64 cap = 64 * 1024;
+	u64 size = 0;
+	char* contents = (char*)malloc(cap + SOURCE_FILE_PADDING);
+	for (;;) {
+		if (size == cap) {
+			cap *= 2;
+			contents = (char*)realloc(contents, cap + SOURCE_FILE_PADDING);
+		}
+		ssize_t n = read(fd, contents + size, cap - size);
+		if (n == 0) break;
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			free(contents);
+			return null;
+		}
+		size += n;
+	}
+	memset(contents + size, 0, SOURCE_FILE_PADDING);
+	*len = size;
+	return contents;
+}
+
+#if SOURCE_FILE_MMAP
+/* reserves zeroed anonymous pages for the file plus padding, then maps
+ * the file over the front of the reservation. the tail of the last file
+ * page reads as zero, and the padding lands in the anonymous pages */
+static char* map_fd_padded(int fd, u64 size, u64* map_len) {
+	u64 page = (u64)sysconf(_SC_PAGESIZE);
+	u64 file_pages = ALIGN_UP(size, page);
+	u64 total = ALIGN_UP(size + SOURCE_FILE_PADDING, page);
+
+	void* base = mmap(null, total, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) return null;
+	void* contents = mmap(base, file_pages, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+	if (contents == MAP_FAILED) {
+		munmap(base, total);
+		return null;
+	}
+	madvise(contents, file_pages, MADV_SEQUENTIAL);
+	*map_len = total;
+	return (char*)contents;
+}
+#endif
+
 SourceFile* read_file(const char* fpath) {
-	/* TODO: more thorough error checking */
-	FILE* fp = fopen(fpath, "r");
-	if (!fp) return null;
-	fseek(fp, 0, SEEK_END);
-	uint size = ftell(fp);
-	rewind(fp);
+	bool is_stdin = (strcmp(fpath, "-") == 0);
+	int fd = (is_stdin ? STDIN_FILENO : open(fpath, O_RDONLY));
+	if (fd < 0) return null;
 
-	char* contents = (char*)malloc(size + 1);
-	fread((void*)contents, sizeof(char), size, fp);
-	fclose(fp);
+	struct stat st;
+	if (fstat(fd, &st) != 0 || S_ISDIR(st.st_mode)) {
+		if (!is_stdin) close(fd);
+		return null;
+	}
+
+	char* contents = null;
+	u64 len = 0;
+	u64 map_len = 0;
+#if SOURCE_FILE_MMAP
+	/* pipes, ttys and empty files go through read() */
+	if (S_ISREG(st.st_mode) && st.st_size > 0) {
+		len = (u64)st.st_size;
+		contents = map_fd_padded(fd, len, &map_len);
+	}
+#endif
+	if (!contents) {
+		contents = read_fd_padded(fd, &len);
+	}
+	if (!is_stdin) close(fd);
+	if (!contents) return null;
 
 	SourceFile* file = (SourceFile*)malloc(sizeof(SourceFile));
-	file->fpath = const_cast<char*>(fpath);
+	file->fpath = const_cast<char*>(is_stdin ? "<stdin>" : fpath);
 	file->contents = contents;
-	file->len = size;
+	file->len = len;
+	file->map_len = map_len;
+	file->line_starts = null;
+
+	std::lock_guard<std::mutex> lock(source_files_mutex);
+	if (source_files_len > UINT16_MAX) {
+		ether_abort("too many source files;");
+	}
+	file->id = (u16)source_files_len;
+	source_files[source_files_len++] = file;
 	return file;
 }
 
+SourceFile* source_file_from_id(u16 id) {
+	if (id == SOURCE_FILE_NONE) {
+		return null;
+	}
+	return source_files[id];
+}
+
+/* unmaps or frees the contents; the id no longer finds the file */
+void free_file(SourceFile* file) {
+	source_files[file->id] = null;
+#if SOURCE_FILE_MMAP
+	if (file->map_len) {
+		munmap(file->contents, file->map_len);
+	}
+	else
+#endif
+	{
+		free(file->contents);
+	}
+	buf_free(file->line_starts);
+	free(file);
+}
+
 bool file_exists(const char* fpath) {
 	FILE* fp = fopen(fpath, "r");
 	if (fp) return true;
 	return false;
 }
 
+/* interned absolute path with symlinks, ‘.’ and ‘..’ resolved, or null
+ * when the file does not exist */
+char* canonicalize_fpath(const char* fpath) {
+	char* resolved = realpath(fpath, null);
+	if (!resolved) return null;
+	char* canonical = str_intern(resolved);
+	free(resolved);
+	return canonical;
+}
+
+void build_line_table(SourceFile* file) {
+	if (file->line_starts) return;
+	buf_push(file->line_starts, 0);
+
+	char* c = file->contents;
+	char* end = file->contents + file->len;
+	while ((c = (char*)memchr(c, '\n', end - c)) != null) {
+		c++;
+		buf_push(file->line_starts, (u64)(c - file->contents));
+	}
+}
+
+void get_position_at(SourceFile* file, u64 offset, u64* line, u64* column) {
+	assert(offset <= file->len);
+	build_line_table(file);
+
+	/* find the last line that starts at or before offset */
+	u64 lo = 0;
+	u64 hi = buf_len(file->line_starts);
+	while (hi - lo > 1) {
+		u64 mid = lo + (hi - lo) / 2;
+		if (file->line_starts[mid] <= offset) lo = mid;
+		else hi = mid;
+	}
+	*line = lo + 1;
+	*column = offset - file->line_starts[lo] + 1;
+}
+
 char* get_line_at(SourceFile* file, u64 line) {
 	assert(line != 0);
 	assert(file->contents);
+	build_line_table(file);
 
-	const u64 target_newline = line - 1;
-	u64 newline_count = 0;
-	char* line_to_print = file->contents;
-
-	while (newline_count < target_newline) {
-		while (*line_to_print != '\n') {
-			if (*line_to_print == '\0') return null;
-			++line_to_print;
-		}
-		++line_to_print;
-		++newline_count;
-	}
-	return line_to_print;
+	if (line > buf_len(file->line_starts)) return null;
+	return file->contents + file->line_starts[line - 1];
 }
 
 error_code print_file_line(SourceFile* file, u64 line) {
@@ -96,3 +233,138 @@ void print_tab(void) {
 		fprintf(stderr, " ");
 	}
 }
+
+error_code writer_open(Writer* writer, char* fpath) {
+	/* units writing on other threads need distinct temporary names */
+	static std::atomic<u64> tmp_count;
+	char* tmp_fpath = null;
+	buf_printf(tmp_fpath, "%s.tmp.%d.%lu", fpath, (int)getpid(), tmp_count++);
+
+	int fd = open(tmp_fpath, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+	if (fd == -1) {
+		ether_print_error("cannot open ‘%s’ for writing: %s;", tmp_fpath, strerror(errno));
+		buf_free(tmp_fpath);
+		return ETHER_ERROR;
+	}
+
+	writer->fpath = fpath;
+	writer->tmp_fpath = tmp_fpath;
+	writer->fd = fd;
+	writer->buf = (char*)malloc(WRITER_BUFFER_SIZE);
+	writer->len = 0;
+	writer->error = 0;
+	return ETHER_SUCCESS;
+}
+
+/* writes every iovec out, retrying short writes */
+static void writer_writev(Writer* writer, struct iovec* iov, int iovcnt) {
+	while (iovcnt > 0 && !writer->error) {
+		ssize_t n = writev(writer->fd, iov, iovcnt);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			writer->error = errno;
+			return;
+		}
+
+		while (iovcnt > 0 && (u64)n >= iov->iov_len) {
+			n -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0) {
+			iov->iov_base = (char*)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+}
+
+void writer_write(Writer* writer, const char* data, u64 len) {
+	if (writer->len + len <= WRITER_BUFFER_SIZE) {
+		memcpy(writer->buf + writer->len, data, len);
+		writer->len += len;
+		return;
+	}
+
+	/* the buffered bytes and the new data go out in one syscall,
+	 * without copying data that would not fit anyway */
+	struct iovec iov[2];
+	iov[0].iov_base = writer->buf;
+	iov[0].iov_len = writer->len;
+	iov[1].iov_base = (void*)data;
+	iov[1].iov_len = len;
+	writer_writev(writer, iov, 2);
+	writer->len = 0;
+}
+
+void writer_write_str(Writer* writer, const char* str) {
+	writer_write(writer, str, strlen(str));
+}
+
+void writer_write_char(Writer* writer, char ch) {
+	if (writer->len == WRITER_BUFFER_SIZE) {
+		writer_write(writer, &ch, 1);
+		return;
+	}
+	writer->buf[writer->len++] = ch;
+}
+
+static void writer_close(Writer* writer) {
+	if (close(writer->fd) == -1 && !writer->error) {
+		writer->error = errno;
+	}
+	free(writer->buf);
+	writer->buf = null;
+	writer->fd = -1;
+}
+
+error_code writer_commit(Writer* writer) {
+	struct iovec iov;
+	iov.iov_base = writer->buf;
+	iov.iov_len = writer->len;
+	writer_writev(writer, &iov, 1);
+	writer->len = 0;
+	writer_close(writer);
+
+	if (!writer->error && rename(writer->tmp_fpath, writer->fpath) == -1) {
+		writer->error = errno;
+	}
+	if (writer->error) {
+		ether_print_error("cannot write ‘%s’: %s;", writer->fpath, strerror(writer->error));
+		unlink(writer->tmp_fpath);
+	}
+	buf_free(writer->tmp_fpath);
+	return (writer->error ?
+			ETHER_ERROR :
+			ETHER_SUCCESS);
+}
+
+void writer_discard(Writer* writer) {
+	writer_close(writer);
+	unlink(writer->tmp_fpath);
+	buf_free(writer->tmp_fpath);
+}
+
+/* runs argv[0], found on the PATH, and waits for it. its output goes
+ * straight to ours */
+error_code run_program(char** argv) {
+	pid_t pid;
+	int spawn_error = posix_spawnp(&pid, argv[0], null, null, argv, environ);
+	if (spawn_error != 0) {
+		ether_print_error("cannot run ‘%s’: %s;", argv[0], strerror(spawn_error));
+		return ETHER_ERROR;
+	}
+
+	int status;
+	while (waitpid(pid, &status, 0) == -1) {
+		if (errno != EINTR) {
+			ether_print_error("cannot wait for ‘%s’: %s;", argv[0], strerror(errno));
+			return ETHER_ERROR;
+		}
+	}
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		ether_print_error("‘%s’ failed;", argv[0]);
+		return ETHER_ERROR;
+	}
+	return ETHER_SUCCESS;
+}
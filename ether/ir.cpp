@@ -0,0 +1,679 @@
+#include <ir.hpp>
+#include <stmt.hpp>
+#include <expr.hpp>
+#include <token.hpp>
+#include <data_type.hpp>
+#include <profile.hpp>
+
+#include <string>
+
+static const char* op_names[_IR_OP_COUNT] = {
+	"const",
+	"string",
+	"global",
+	"local",
+	"load",
+	"store",
+	"copy",
+	"field",
+	"index",
+	"add",
+	"sub",
+	"mul",
+	"div",
+	"mod",
+	"and",
+	"or",
+	"shl",
+	"shr",
+	"eq",
+	"ne",
+	"lt",
+	"le",
+	"gt",
+	"ge",
+	"neg",
+	"not",
+	"lnot",
+	"cast",
+	"call",
+	"jump",
+	"branch",
+	"ret",
+};
+
+const char* ir_op_name(IrOp op) {
+	return op_names[op];
+}
+
+bool ir_is_terminator(IrOp op) {
+	return op == IR_JUMP || op == IR_BRANCH || op == IR_RET;
+}
+
+char* ir_function_name(Stmt* stmt) {
+	if (!stmt->func_decl.struct_in) {
+		return stmt->func_decl.identifier->lexeme;
+	}
+	std::string name = stmt->func_decl.struct_in->struct_stmt.identifier->lexeme;
+	name += '.';
+	name += stmt->func_decl.identifier->lexeme;
+	return str_intern((char*)name.c_str());
+}
+
+/* the byte a char literal stands for; the lexeme excludes the quotes */
+u8 ir_char_value(char* lexeme) {
+	if (lexeme[0] != '\\') {
+		return (u8)lexeme[0];
+	}
+	switch (lexeme[1]) {
+	case 'n': return '\n';
+	case 'r': return '\r';
+	case 't': return '\t';
+	case '0': return '\0';
+	default: return (u8)lexeme[1];
+	}
+}
+
+void ir_free(IrUnit* unit) {
+	buf_loop(unit->functions, f) {
+		IrFunction* function = &unit->functions[f];
+		buf_free(function->locals);
+		buf_free(function->reg_types);
+		buf_free(function->instrs);
+		buf_free(function->blocks);
+		buf_free(function->block_order);
+		buf_free(function->args);
+	}
+	buf_free(unit->functions);
+	delete unit;
+}
+
+IrUnit* IrBuilder::build(Stmt** _stmts) {
+	stmts = _stmts;
+	structs = {};
+	addr_types = {};
+	unit = new IrUnit;
+	unit->functions = null;
+	function = null;
+	locals = {};
+
+	buf_loop(stmts, s) {
+		Stmt* stmt = stmts[s];
+		if (stmt->type == S_STRUCT &&
+			!map_get(&structs, stmt->struct_stmt.identifier->lexeme)) {
+			map_put(&structs, stmt->struct_stmt.identifier->lexeme, stmt);
+		}
+	}
+
+	/* functions is final before any is built, so function stays valid */
+	u64 function_count = 0;
+	buf_loop(stmts, s) {
+		if (stmts[s]->type == S_FUNC_DECL &&
+			stmts[s]->func_decl.is_function) {
+			function_count++;
+		}
+	}
+	buf_fit(unit->functions, function_count);
+
+	buf_loop(stmts, s) {
+		if (stmts[s]->type == S_FUNC_DECL &&
+			stmts[s]->func_decl.is_function) {
+			ProfileMark mark = profile_stmt_begin();
+			build_function(stmts[s]);
+			profile_stmt_end(mark, PHASE_IR, stmts[s]);
+		}
+	}
+
+	map_free(&structs);
+	map_free(&addr_types);
+	map_free(&locals);
+	return unit;
+}
+
+void IrBuilder::build_function(Stmt* stmt) {
+	buf_push(unit->functions, IrFunction{});
+	function = (buf_end(unit->functions) - 1);
+	function->decl = stmt;
+	map_free(&locals);
+	locals = {};
+
+	Stmt* struct_in = stmt->func_decl.struct_in;
+	if (struct_in) {
+		DataType* this_type = data_type_canonical(struct_in->struct_stmt.identifier->lexeme,
+												  1, false, null);
+		buf_push(function->locals, IrLocal{ this_type, str_intern("this") });
+	}
+	buf_loop(stmt->func_decl.params, p) {
+		Stmt* param = stmt->func_decl.params[p];
+		DataType* data_type = param->var_decl.data_type;
+		if (data_type->is_array) {
+			data_type = addr_type(data_type);
+		}
+		map_put_u64_from_u64(&locals, (u64)param, add_local(data_type, param->var_decl.identifier) + 1);
+	}
+	function->param_count = buf_len(function->locals);
+
+	terminated = true;
+	start_block(new_block());
+	build_body(stmt->func_decl.body);
+	if (!terminated) {
+		IrInstr* instr = emit(IR_RET, null, stmt->func_decl.identifier);
+		instr->a = IR_NO_REG;
+	}
+	function = null;
+}
+
+u32 IrBuilder::add_local(DataType* data_type, Token* identifier) {
+	buf_push(function->locals, IrLocal{ data_type->canonical, identifier ? identifier->lexeme : null });
+	return buf_len(function->locals) - 1;
+}
+
+u32 IrBuilder::new_reg(DataType* data_type) {
+	buf_push(function->reg_types, data_type->canonical);
+	return buf_len(function->reg_types) - 1;
+}
+
+u32 IrBuilder::new_block() {
+	buf_push(function->blocks, IrBlock{});
+	return buf_len(function->blocks) - 1;
+}
+
+/* blocks are laid out in the order they are started, and a block is
+ * only started once the one before it is terminated */
+void IrBuilder::start_block(u32 block) {
+	assert(terminated);
+	function->blocks[block].first = buf_len(function->instrs);
+	function->blocks[block].count = 0;
+	buf_push(function->block_order, block);
+	current_block = block;
+	terminated = false;
+}
+
+IrInstr* IrBuilder::emit(IrOp op, DataType* data_type, Token* token) {
+	if (terminated) {
+		start_block(new_block());
+	}
+
+	IrInstr instr = {};
+	instr.op = op;
+	instr.dst = IR_NO_REG;
+	instr.a = IR_NO_REG;
+	instr.b = IR_NO_REG;
+	instr.type = data_type ? data_type->canonical : null;
+	instr.token = token;
+	buf_push(function->instrs, instr);
+	function->blocks[current_block].count++;
+	terminated = ir_is_terminator(op);
+	return (buf_end(function->instrs) - 1);
+}
+
+u32 IrBuilder::emit_value(IrOp op, DataType* reg_type, DataType* data_type, Token* token, u32 a, u32 b) {
+	IrInstr* instr = emit(op, data_type, token);
+	instr->dst = new_reg(reg_type);
+	instr->a = a;
+	instr->b = b;
+	return instr->dst;
+}
+
+void IrBuilder::emit_jump(u32 block, Token* token) {
+	IrInstr* instr = emit(IR_JUMP, null, token);
+	instr->target.then_block = block;
+}
+
+void IrBuilder::emit_branch(u32 cond, u32 then_block, u32 else_block, Token* token) {
+	IrInstr* instr = emit(IR_BRANCH, data_types.t_bool, token);
+	instr->a = cond;
+	instr->target.then_block = then_block;
+	instr->target.else_block = else_block;
+}
+
+u32 IrBuilder::emit_local(u32 local, Token* token) {
+	DataType* data_type = function->locals[local].type;
+	u32 addr = emit_value(IR_LOCAL, addr_type(data_type), data_type, token, IR_NO_REG, IR_NO_REG);
+	(buf_end(function->instrs) - 1)->imm = local;
+	return addr;
+}
+
+u32 IrBuilder::emit_load_local(u32 local, Token* token) {
+	DataType* data_type = function->locals[local].type;
+	u32 addr = emit_local(local, token);
+	return emit_value(IR_LOAD, data_type, data_type, token, addr, IR_NO_REG);
+}
+
+void IrBuilder::emit_store(u32 addr, u32 value, DataType* data_type, Token* token) {
+	IrInstr* instr = emit(is_aggregate(data_type) ? IR_COPY : IR_STORE, data_type, token);
+	instr->a = addr;
+	instr->b = value;
+}
+
+void IrBuilder::build_stmt(Stmt* stmt) {
+	switch (stmt->type) {
+	case S_STRUCT:
+	case S_FUNC_DECL:
+		/* only found at global scope */
+		assert(0);
+		break;
+	case S_VAR_DECL:
+		build_var_decl(stmt);
+		break;
+	case S_IF:
+		build_if_stmt(stmt);
+		break;
+	case S_FOR:
+		build_for_stmt(stmt);
+		break;
+	case S_SWITCH:
+		build_switch_stmt(stmt);
+		break;
+	case S_RETURN:
+		build_return_stmt(stmt);
+		break;
+	case S_EXPR_STMT:
+		build_expr(stmt->expr_stmt);
+		break;
+	case S_BLOCK:
+		build_body(stmt->block);
+		break;
+	}
+}
+
+void IrBuilder::build_body(Stmt** body) {
+	buf_loop(body, s) {
+		build_stmt(body[s]);
+	}
+}
+
+/* locals are not zeroed, as in C */
+void IrBuilder::build_var_decl(Stmt* stmt) {
+	u32 local = add_local(stmt->var_decl.data_type, stmt->var_decl.identifier);
+	map_put_u64_from_u64(&locals, (u64)stmt, local + 1);
+	if (stmt->var_decl.initializer) {
+		Token* token = stmt->var_decl.identifier;
+		u32 value = build_expr(stmt->var_decl.initializer);
+		emit_store(emit_local(local, token), value, stmt->var_decl.data_type, token);
+	}
+}
+
+void IrBuilder::build_if_stmt(Stmt* stmt) {
+	u32 end_block = new_block();
+	IfBranch* branch = stmt->if_stmt.if_branch;
+	u64 elif_count = buf_len(stmt->if_stmt.elif_branch);
+
+	for (u64 b = 0; b <= elif_count; ++b) {
+		if (b != 0) {
+			branch = stmt->if_stmt.elif_branch[b - 1];
+		}
+		u32 then_block = new_block();
+		u32 next_block = new_block();
+		u32 cond = build_expr(branch->cond);
+		emit_branch(cond, then_block, next_block, branch->cond->head);
+		start_block(then_block);
+		build_body(branch->body);
+		emit_jump(end_block, branch->cond->head);
+		start_block(next_block);
+	}
+
+	if (stmt->if_stmt.else_branch) {
+		build_body(stmt->if_stmt.else_branch->body);
+	}
+	emit_jump(end_block, null);
+	start_block(end_block);
+}
+
+/* the end is evaluated once, before the first iteration, and is
+ * exclusive */
+void IrBuilder::build_for_stmt(Stmt* stmt) {
+	Stmt* counter = stmt->for_stmt.counter;
+	DataType* data_type = counter->var_decl.data_type;
+	Token* token = counter->var_decl.identifier;
+	u32 counter_local = add_local(data_type, token);
+	u32 end_local = add_local(data_type, null);
+	map_put_u64_from_u64(&locals, (u64)counter, counter_local + 1);
+
+	u32 value;
+	if (counter->var_decl.initializer) {
+		value = build_expr(counter->var_decl.initializer);
+	}
+	else {
+		value = emit_value(IR_CONST, data_type, data_type, token, IR_NO_REG, IR_NO_REG);
+		(buf_end(function->instrs) - 1)->imm = 0;
+	}
+	emit_store(emit_local(counter_local, token), value, data_type, token);
+	value = build_expr(stmt->for_stmt.end);
+	emit_store(emit_local(end_local, token), value, data_type, token);
+
+	u32 cond_block = new_block();
+	u32 body_block = new_block();
+	u32 exit_block = new_block();
+	emit_jump(cond_block, token);
+	start_block(cond_block);
+	u32 i = emit_load_local(counter_local, token);
+	u32 end = emit_load_local(end_local, token);
+	u32 cond = emit_value(IR_LT, data_types.t_bool, data_type, token, i, end);
+	emit_branch(cond, body_block, exit_block, token);
+
+	start_block(body_block);
+	build_body(stmt->for_stmt.body);
+	i = emit_load_local(counter_local, token);
+	u32 one = emit_value(IR_CONST, data_type, data_type, token, IR_NO_REG, IR_NO_REG);
+	(buf_end(function->instrs) - 1)->imm = 1;
+	u32 next = emit_value(IR_ADD, data_type, data_type, token, i, one);
+	emit_store(emit_local(counter_local, token), next, data_type, token);
+	emit_jump(cond_block, token);
+	start_block(exit_block);
+}
+
+/* branch conditions need not be constant, so each is compared in turn
+ * with the condition, which is evaluated once */
+void IrBuilder::build_switch_stmt(Stmt* stmt) {
+	Expr* cond_expr = stmt->switch_stmt.cond;
+	DataType* data_type = cond_expr->data_type;
+	Token* token = cond_expr->head;
+	u32 cond_local = add_local(data_type, null);
+	u32 cond = build_expr(cond_expr);
+	emit_store(emit_local(cond_local, token), cond, data_type, token);
+
+	u32 end_block = new_block();
+	buf_loop(stmt->switch_stmt.branches, b) {
+		SwitchBranch* branch = stmt->switch_stmt.branches[b];
+		u32 body_block = new_block();
+		u32 next_block = new_block();
+		buf_loop(branch->conds, c) {
+			Token* cond_token = branch->conds[c]->head;
+			u32 value = build_expr(branch->conds[c]);
+			cond = emit_load_local(cond_local, cond_token);
+			u32 equal = emit_value(IR_EQ, data_types.t_bool, data_type, cond_token, cond, value);
+			u32 test_block = (c + 1 == buf_len(branch->conds) ? next_block : new_block());
+			emit_branch(equal, body_block, test_block, cond_token);
+			if (test_block != next_block) {
+				start_block(test_block);
+			}
+		}
+		start_block(body_block);
+		build_stmt(branch->stmt);
+		emit_jump(end_block, token);
+		start_block(next_block);
+	}
+	emit_jump(end_block, token);
+	start_block(end_block);
+}
+
+void IrBuilder::build_return_stmt(Stmt* stmt) {
+	Expr* to_return = stmt->return_stmt.to_return;
+	u32 value = IR_NO_REG;
+	if (to_return) {
+		value = build_expr(to_return);
+	}
+	IrInstr* instr = emit(IR_RET,
+						  to_return ? to_return->data_type : null,
+						  function->decl->func_decl.identifier);
+	instr->a = value;
+}
+
+u32 IrBuilder::build_expr(Expr* expr) {
+	switch (expr->type) {
+	case E_BINARY:
+		switch (expr->binary.op->type) {
+		case T_EQUAL:
+			return build_assign_expr(expr);
+		case T_AMPERSAND_AMPERSAND:
+		case T_BAR_BAR:
+			return build_logic_binary_expr(expr);
+		default:
+			return build_binary_expr(expr);
+		}
+	case E_UNARY:
+		return build_unary_expr(expr);
+	case E_CAST: {
+		u32 value = build_expr(expr->cast.right);
+		return emit_value(IR_CAST, expr->cast.cast_to, expr->cast.cast_to, expr->head, value, IR_NO_REG);
+	}
+	case E_FUNC_CALL:
+		return build_func_call(expr);
+	case E_ARRAY_ACCESS:
+	case E_MEMBER_ACCESS:
+	case E_VARIABLE_REF: {
+		u32 addr = build_addr(expr);
+		if (is_aggregate(expr->data_type)) {
+			return addr;
+		}
+		return emit_value(IR_LOAD, expr->data_type, expr->data_type, expr->head, addr, IR_NO_REG);
+	}
+	case E_STRING: {
+		u32 str = emit_value(IR_STRING, expr->data_type, expr->data_type, expr->head, IR_NO_REG, IR_NO_REG);
+		(buf_end(function->instrs) - 1)->str = expr->string->lexeme;
+		return str;
+	}
+	case E_NUMBER:
+	case E_CHAR:
+	case E_CONSTANT:
+		return build_constant(expr);
+	}
+	assert(0);
+	return IR_NO_REG;
+}
+
+u32 IrBuilder::build_addr(Expr* expr) {
+	switch (expr->type) {
+	case E_VARIABLE_REF: {
+		Stmt* variable = expr->variable_ref.variable_refed;
+		DataType* data_type = variable->var_decl.data_type;
+		if (expr->variable_ref.depth == 0) {
+			u32 addr = emit_value(IR_GLOBAL, addr_type(data_type), data_type, expr->head, IR_NO_REG, IR_NO_REG);
+			(buf_end(function->instrs) - 1)->stmt = variable;
+			return addr;
+		}
+		/* in a struct function, scope 1 holds the struct's fields (see
+		 * Linker::check_struct) */
+		if (function->decl->func_decl.struct_in && expr->variable_ref.depth == 1) {
+			u32 this_ptr = emit_load_local(0, expr->head);
+			u32 addr = emit_value(IR_FIELD, addr_type(data_type), data_type, expr->head, this_ptr, IR_NO_REG);
+			(buf_end(function->instrs) - 1)->stmt = variable;
+			return addr;
+		}
+
+		u32 local = (u32)map_get_u64_from_u64(&locals, (u64)variable) - 1;
+		if (local < function->param_count && data_type->is_array) {
+			return emit_load_local(local, expr->head);
+		}
+		return emit_local(local, expr->head);
+	}
+	case E_ARRAY_ACCESS: {
+		/* an array evaluates to its address, a pointer to itself */
+		u32 base = build_expr(expr->array_access.left);
+		u32 index = build_expr(expr->array_access.index);
+		return emit_value(IR_INDEX, addr_type(expr->data_type), expr->data_type, expr->head, base, index);
+	}
+	case E_MEMBER_ACCESS: {
+		u32 base = build_expr(expr->member_access.left);
+		u32 addr = emit_value(IR_FIELD, addr_type(expr->data_type), expr->data_type, expr->head, base, IR_NO_REG);
+		(buf_end(function->instrs) - 1)->stmt = expr->member_access.field;
+		return addr;
+	}
+	case E_UNARY:
+		if (expr->unary.op->type == T_CARET) {
+			return build_expr(expr->unary.right);
+		}
+		break;
+	default:
+		break;
+	}
+	/* the parser and resolve only let lvalues get here */
+	assert(0);
+	return IR_NO_REG;
+}
+
+u32 IrBuilder::build_binary_expr(Expr* expr) {
+	IrOp op;
+	DataType* reg_type = expr->data_type;
+	switch (expr->binary.op->type) {
+	case T_PLUS: op = IR_ADD; break;
+	case T_MINUS: op = IR_SUB; break;
+	case T_ASTERISK: op = IR_MUL; break;
+	case T_SLASH: op = IR_DIV; break;
+	case T_PERCENT: op = IR_MOD; break;
+	case T_AMPERSAND: op = IR_AND; break;
+	case T_BAR: op = IR_OR; break;
+	case T_LESS_LESS: op = IR_SHL; break;
+	case T_GREATER_GREATER: op = IR_SHR; break;
+	case T_EQUAL_EQUAL: op = IR_EQ; break;
+	case T_BANG_EQUAL: op = IR_NE; break;
+	case T_LANGBKT: op = IR_LT; break;
+	case T_LESS_EQUAL: op = IR_LE; break;
+	case T_RANGBKT: op = IR_GT; break;
+	case T_GREATER_EQUAL: op = IR_GE; break;
+	default:
+		assert(0);
+		return IR_NO_REG;
+	}
+
+	u32 left = build_expr(expr->binary.left);
+	u32 right = build_expr(expr->binary.right);
+	return emit_value(op, reg_type, expr->binary.left->data_type, expr->binary.op, left, right);
+}
+
+/* the value goes through a local, since the right side is only
+ * evaluated when the left does not decide */
+u32 IrBuilder::build_logic_binary_expr(Expr* expr) {
+	bool is_and = expr->binary.op->type == T_AMPERSAND_AMPERSAND;
+	Token* token = expr->binary.op;
+	u32 result = add_local(data_types.t_bool, null);
+	u32 right_block = new_block();
+	u32 end_block = new_block();
+
+	u32 left = build_expr(expr->binary.left);
+	emit_store(emit_local(result, token), left, data_types.t_bool, token);
+	if (is_and) {
+		emit_branch(left, right_block, end_block, token);
+	}
+	else {
+		emit_branch(left, end_block, right_block, token);
+	}
+
+	start_block(right_block);
+	u32 right = build_expr(expr->binary.right);
+	emit_store(emit_local(result, token), right, data_types.t_bool, token);
+	emit_jump(end_block, token);
+
+	start_block(end_block);
+	return emit_load_local(result, token);
+}
+
+u32 IrBuilder::build_assign_expr(Expr* expr) {
+	DataType* data_type = expr->binary.left->data_type;
+	u32 value = build_expr(expr->binary.right);
+	u32 addr = build_addr(expr->binary.left);
+	emit_store(addr, value, data_type, expr->binary.op);
+	return value;
+}
+
+u32 IrBuilder::build_unary_expr(Expr* expr) {
+	Token* token = expr->unary.op;
+	switch (expr->unary.op->type) {
+	case T_AMPERSAND:
+		return build_addr(expr->unary.right);
+	case T_CARET: {
+		u32 addr = build_expr(expr->unary.right);
+		if (is_aggregate(expr->data_type)) {
+			return addr;
+		}
+		return emit_value(IR_LOAD, expr->data_type, expr->data_type, token, addr, IR_NO_REG);
+	}
+	case T_PLUS:
+		return build_expr(expr->unary.right);
+	case T_MINUS: {
+		u32 value = build_expr(expr->unary.right);
+		return emit_value(IR_NEG, expr->data_type, expr->data_type, token, value, IR_NO_REG);
+	}
+	case T_TILDE: {
+		u32 value = build_expr(expr->unary.right);
+		return emit_value(IR_NOT, expr->data_type, expr->data_type, token, value, IR_NO_REG);
+	}
+	case T_BANG: {
+		u32 value = build_expr(expr->unary.right);
+		return emit_value(IR_LNOT, expr->data_type, expr->data_type, token, value, IR_NO_REG);
+	}
+	default:
+		assert(0);
+		return IR_NO_REG;
+	}
+}
+
+/* the arguments are evaluated first, since they may call too, and
+ * then stored together. a struct function gets its struct's address
+ * first */
+u32 IrBuilder::build_func_call(Expr* expr) {
+	Stmt* called = expr->func_call.function_called;
+	u32* arg_regs = null;
+	if (called->func_decl.struct_in) {
+		buf_push(arg_regs, build_expr(expr->func_call.left->member_access.left));
+	}
+	buf_loop(expr->func_call.args, a) {
+		buf_push(arg_regs, build_expr(expr->func_call.args[a]));
+	}
+
+	u32 arg_start = buf_len(function->args);
+	buf_loop(arg_regs, a) {
+		buf_push(function->args, arg_regs[a]);
+	}
+
+	DataType* return_type = called->func_decl.return_data_type;
+	IrInstr* instr = emit(IR_CALL, return_type, expr->head);
+	instr->call.function = called;
+	instr->call.arg_start = arg_start;
+	instr->call.arg_count = buf_len(arg_regs);
+	if (data_type_match(return_type, data_types.t_void) == DT_NOT_MATCH) {
+		instr->dst = new_reg(return_type);
+	}
+	buf_free(arg_regs);
+	return (buf_end(function->instrs) - 1)->dst;
+}
+
+u32 IrBuilder::build_constant(Expr* expr) {
+	u32 reg = emit_value(IR_CONST, expr->data_type, expr->data_type, expr->head, IR_NO_REG, IR_NO_REG);
+	IrInstr* instr = (buf_end(function->instrs) - 1);
+	switch (expr->type) {
+	case E_NUMBER:
+		if (expr->number->type == T_INTEGER) {
+			instr->imm = strtoull(expr->number->lexeme, null, 10);
+		}
+		else {
+			double value = strtod(expr->number->lexeme, null);
+			memcpy(&instr->imm, &value, sizeof(value));
+		}
+		break;
+	case E_CHAR:
+		instr->imm = ir_char_value(expr->chr->lexeme);
+		break;
+	case E_CONSTANT:
+		instr->imm = (expr->constant->keyword == KW_TRUE ? 1 : 0);
+		break;
+	default:
+		assert(0);
+		break;
+	}
+	return reg;
+}
+
+bool IrBuilder::is_aggregate(DataType* data_type) {
+	if (data_type->is_array) {
+		return true;
+	}
+	return (data_type->pointer_count == 0 &&
+			map_get(&structs, data_type->identifier->lexeme));
+}
+
+/* the type of a register holding the address of a data_type. an
+ * array's is a pointer to its first element, as in C */
+DataType* IrBuilder::addr_type(DataType* data_type) {
+	DataType* canonical = data_type->canonical;
+	DataType* pointer = (DataType*)map_get(&addr_types, canonical);
+	if (!pointer) {
+		pointer = data_type_canonical(canonical->identifier->lexeme,
+									  canonical->pointer_count + 1,
+									  false,
+									  null);
+		map_put(&addr_types, canonical, pointer);
+	}
+	return pointer;
+}
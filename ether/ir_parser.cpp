@@ -0,0 +1,531 @@
+#include <ir_parser.hpp>
+#include <ir_printer.hpp>
+#include <stmt.hpp>
+#include <token.hpp>
+#include <data_type.hpp>
+
+static char empty_text[] = "";
+
+IrUnit* IrParser::parse(Stmt** _stmts, char* text) {
+	stmts = _stmts;
+	cursor = text;
+	line = 1;
+	failed = false;
+	functions = {};
+	globals = {};
+	structs = {};
+	unit = new IrUnit;
+	unit->functions = null;
+	function = null;
+
+	buf_loop(stmts, s) {
+		Stmt* stmt = stmts[s];
+		switch (stmt->type) {
+		case S_FUNC_DECL: {
+			char* name = ir_function_name(stmt);
+			if (!map_get(&functions, name)) {
+				map_put(&functions, name, stmt);
+			}
+		} break;
+		case S_VAR_DECL:
+			if (!map_get(&globals, stmt->var_decl.identifier->lexeme)) {
+				map_put(&globals, stmt->var_decl.identifier->lexeme, stmt);
+			}
+			break;
+		case S_STRUCT:
+			if (!map_get(&structs, stmt->struct_stmt.identifier->lexeme)) {
+				map_put(&structs, stmt->struct_stmt.identifier->lexeme, stmt);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	while (*cursor) {
+		parse_function();
+		match("\n");
+	}
+
+	map_free(&functions);
+	map_free(&globals);
+	map_free(&structs);
+	if (failed) {
+		ir_free(unit);
+		return null;
+	}
+	return unit;
+}
+
+void IrParser::parse_function() {
+	buf_push(unit->functions, IrFunction{});
+	function = (buf_end(unit->functions) - 1);
+
+	expect("func @");
+	char* name = parse_name();
+	function->decl = (Stmt*)map_get(&functions, name);
+	if (!failed && !function->decl) {
+		fail("unknown function ‘%s’", name);
+	}
+	expect(" params ");
+	function->param_count = (u32)parse_u64();
+	expect("\n");
+
+	while (match("\t$")) {
+		if (parse_u64() != buf_len(function->locals)) {
+			fail("locals are numbered in order");
+		}
+		expect(" ");
+		DataType* data_type = parse_data_type();
+		expect(" ");
+		char* local_name = parse_name();
+		if (local_name && strcmp(local_name, "-") == 0) {
+			local_name = null;
+		}
+		buf_push(function->locals, IrLocal{ data_type, local_name });
+		expect("\n");
+	}
+
+	while (!failed && *cursor == 'b') {
+		u32 block = parse_block();
+		expect(":\n");
+		while (!failed && block >= buf_len(function->blocks)) {
+			buf_push(function->blocks, IrBlock{});
+		}
+		if (failed) {
+			break;
+		}
+		function->blocks[block].first = buf_len(function->instrs);
+		function->blocks[block].count = 0;
+		buf_push(function->block_order, block);
+
+		while (match("\t")) {
+			parse_instr();
+			function->blocks[block].count++;
+			expect("\n");
+		}
+	}
+	function = null;
+}
+
+/* [%dst type = ]op[ type][ operands] */
+void IrParser::parse_instr() {
+	IrInstr instr = {};
+	instr.dst = IR_NO_REG;
+	instr.a = IR_NO_REG;
+	instr.b = IR_NO_REG;
+
+	if (*cursor == '%') {
+		instr.dst = parse_reg();
+		if (!failed && instr.dst != buf_len(function->reg_types)) {
+			fail("registers are numbered in order");
+		}
+		expect(" ");
+		buf_push(function->reg_types, parse_data_type());
+		expect(" = ");
+	}
+
+	char* op_name = parse_name();
+	instr.op = _IR_OP_COUNT;
+	for (int op = 0; op < _IR_OP_COUNT && op_name; ++op) {
+		if (strcmp(op_name, ir_op_name((IrOp)op)) == 0) {
+			instr.op = (IrOp)op;
+			break;
+		}
+	}
+	if (instr.op == _IR_OP_COUNT) {
+		fail("unknown operation ‘%s’", op_name ? op_name : "");
+		return;
+	}
+
+	if (instr.op != IR_JUMP && !(instr.op == IR_RET && at_line_end())) {
+		expect(" ");
+		instr.type = parse_data_type();
+	}
+	parse_operands(&instr);
+	buf_push(function->instrs, instr);
+}
+
+void IrParser::parse_operands(IrInstr* instr) {
+	switch (instr->op) {
+	case IR_CONST:
+		expect(" ");
+		if (instr->type == data_types.t_f32 || instr->type == data_types.t_f64) {
+			char* end;
+			double value = strtod(cursor, &end);
+			if (end == cursor) {
+				fail("expected a number");
+			}
+			cursor = end;
+			memcpy(&instr->imm, &value, sizeof(value));
+		}
+		else {
+			instr->imm = parse_u64();
+		}
+		break;
+	case IR_STRING: {
+		expect(" \"");
+		char* start = cursor;
+		while (*cursor != '"' && *cursor != '\n' && *cursor != '\0') {
+			cursor++;
+		}
+		instr->str = str_intern_range(start, cursor);
+		expect("\"");
+	} break;
+	case IR_GLOBAL: {
+		expect(" @");
+		char* name = parse_name();
+		instr->stmt = (Stmt*)map_get(&globals, name);
+		if (!failed && !instr->stmt) {
+			fail("unknown global ‘%s’", name);
+		}
+	} break;
+	case IR_LOCAL:
+		expect(" $");
+		instr->imm = parse_u64();
+		break;
+	case IR_FIELD: {
+		expect(" ");
+		instr->a = parse_reg();
+		expect(", ");
+		char* name = parse_name();
+		if (failed) {
+			break;
+		}
+		if (instr->a >= buf_len(function->reg_types)) {
+			fail("%%%u is not defined", instr->a);
+			break;
+		}
+		Stmt* struct_stmt = (Stmt*)map_get(&structs, function->reg_types[instr->a]->identifier->lexeme);
+		if (struct_stmt) {
+			buf_loop(struct_stmt->struct_stmt.fields, f) {
+				Stmt* field = struct_stmt->struct_stmt.fields[f];
+				if (field->var_decl.identifier->lexeme == name) {
+					instr->stmt = field;
+					break;
+				}
+			}
+		}
+		if (!instr->stmt) {
+			fail("unknown field ‘%s’", name);
+		}
+	} break;
+	case IR_CALL: {
+		expect(" @");
+		char* name = parse_name();
+		instr->call.function = (Stmt*)map_get(&functions, name);
+		if (!failed && !instr->call.function) {
+			fail("unknown function ‘%s’", name);
+		}
+		expect("(");
+		instr->call.arg_start = buf_len(function->args);
+		instr->call.arg_count = 0;
+		while (!failed && !match(")")) {
+			if (instr->call.arg_count != 0) {
+				expect(", ");
+			}
+			buf_push(function->args, parse_reg());
+			instr->call.arg_count++;
+		}
+	} break;
+	case IR_JUMP:
+		expect(" ");
+		instr->target.then_block = parse_block();
+		break;
+	case IR_BRANCH:
+		expect(" ");
+		instr->a = parse_reg();
+		expect(", ");
+		instr->target.then_block = parse_block();
+		expect(", ");
+		instr->target.else_block = parse_block();
+		break;
+	default:
+		if (!at_line_end()) {
+			expect(" ");
+			instr->a = parse_reg();
+			if (match(", ")) {
+				instr->b = parse_reg();
+			}
+		}
+		break;
+	}
+}
+
+/* [N]^^ident, as data_type_to_string writes it */
+DataType* IrParser::parse_data_type() {
+	char* count = null;
+	bool is_array = false;
+	if (match("[")) {
+		char* start = cursor;
+		while (*cursor >= '0' && *cursor <= '9') {
+			cursor++;
+		}
+		count = str_intern_range(start, cursor);
+		is_array = true;
+		expect("]");
+	}
+	u8 pointer_count = 0;
+	while (match("^")) {
+		pointer_count++;
+	}
+	char* identifier = parse_name();
+	if (failed) {
+		return null;
+	}
+	return data_type_canonical(identifier, pointer_count, is_array, count);
+}
+
+u32 IrParser::parse_reg() {
+	expect("%");
+	return (u32)parse_u64();
+}
+
+u32 IrParser::parse_block() {
+	expect("bb");
+	return (u32)parse_u64();
+}
+
+/* runs to the next separator; names may hold '.' and '-' */
+char* IrParser::parse_name() {
+	char* start = cursor;
+	while (*cursor != ' ' && *cursor != ',' && *cursor != '(' &&
+		   *cursor != ')' && *cursor != ':' && *cursor != '\n' &&
+		   *cursor != '\0') {
+		cursor++;
+	}
+	if (cursor == start) {
+		fail("expected a name");
+		return null;
+	}
+	return str_intern_range(start, cursor);
+}
+
+u64 IrParser::parse_u64() {
+	char* start = cursor;
+	u64 value = 0;
+	while (*cursor >= '0' && *cursor <= '9') {
+		value = value * 10 + (u64)(*cursor - '0');
+		cursor++;
+	}
+	if (cursor == start) {
+		fail("expected a number");
+	}
+	return value;
+}
+
+void IrParser::expect(const char* str) {
+	if (!match(str)) {
+		fail("expected ‘%s’", str);
+	}
+}
+
+bool IrParser::match(const char* str) {
+	u64 len = strlen(str);
+	if (strncmp(cursor, str, len) != 0) {
+		return false;
+	}
+	for (u64 c = 0; c < len; ++c) {
+		if (str[c] == '\n') {
+			line++;
+		}
+	}
+	cursor += len;
+	return true;
+}
+
+bool IrParser::at_line_end() {
+	return *cursor == '\n' || *cursor == '\0';
+}
+
+/* reports the first error and stops the parse */
+void IrParser::fail(const char* fmt, ...) {
+	if (failed) {
+		return;
+	}
+	va_list ap;
+	va_start(ap, fmt);
+	fprintf(stderr, "ir:%lu: ", line);
+	vfprintf(stderr, fmt, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+	failed = true;
+	cursor = empty_text;
+}
+
+static bool check_error(IrFunction* function, const char* fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	fprintf(stderr, "ir: @%s: ", ir_function_name(function->decl));
+	vfprintf(stderr, fmt, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+	return false;
+}
+
+static bool check_function(IrFunction* function) {
+	u32 reg_count = 0;
+	u32 pos = 0;
+	u64 block_count = buf_len(function->blocks);
+	if (buf_len(function->block_order) != block_count) {
+		return check_error(function, "%lu blocks, %lu laid out",
+						   block_count, buf_len(function->block_order));
+	}
+
+	buf_loop(function->block_order, o) {
+		u32 block = function->block_order[o];
+		IrBlock* ir_block = &function->blocks[block];
+		if (ir_block->first != pos || ir_block->count == 0) {
+			return check_error(function, "bb%u is not laid out in order", block);
+		}
+		for (u32 i = ir_block->first; i < ir_block->first + ir_block->count; ++i) {
+			IrInstr* instr = &function->instrs[i];
+			bool is_last = (i + 1 == ir_block->first + ir_block->count);
+			if (ir_is_terminator(instr->op) != is_last) {
+				return check_error(function, "bb%u does not end in its only terminator", block);
+			}
+			if ((instr->a != IR_NO_REG && instr->a >= reg_count) ||
+				(instr->b != IR_NO_REG && instr->b >= reg_count)) {
+				return check_error(function, "%s in bb%u uses a register before it is defined",
+								   ir_op_name(instr->op), block);
+			}
+			if (instr->op == IR_CALL) {
+				for (u32 a = 0; a < instr->call.arg_count; ++a) {
+					if (function->args[instr->call.arg_start + a] >= reg_count) {
+						return check_error(function, "call in bb%u uses a register before it is defined", block);
+					}
+				}
+			}
+			if ((instr->op == IR_JUMP || instr->op == IR_BRANCH) &&
+				(instr->target.then_block >= block_count ||
+				 (instr->op == IR_BRANCH && instr->target.else_block >= block_count))) {
+				return check_error(function, "bb%u jumps to a missing block", block);
+			}
+			if (instr->op == IR_LOCAL && instr->imm >= buf_len(function->locals)) {
+				return check_error(function, "bb%u takes a missing local", block);
+			}
+			if (instr->dst != IR_NO_REG) {
+				if (instr->dst != reg_count) {
+					return check_error(function, "%%%u is not defined in order", instr->dst);
+				}
+				reg_count++;
+			}
+		}
+		pos += ir_block->count;
+	}
+	if (pos != buf_len(function->instrs) || reg_count != buf_len(function->reg_types)) {
+		return check_error(function, "instructions or registers outside the blocks");
+	}
+	return true;
+}
+
+/* statements are compared by name, as that is what the text holds */
+static bool instrs_equal(IrInstr* x, IrInstr* y) {
+	if (x->op != y->op || x->dst != y->dst || x->a != y->a || x->b != y->b ||
+		x->type != y->type) {
+		return false;
+	}
+	switch (x->op) {
+	case IR_CONST:
+	case IR_LOCAL:
+		return x->imm == y->imm;
+	case IR_STRING:
+		return strcmp(x->str, y->str) == 0;
+	case IR_GLOBAL:
+	case IR_FIELD:
+		return x->stmt->var_decl.identifier->lexeme == y->stmt->var_decl.identifier->lexeme;
+	case IR_CALL:
+		return (ir_function_name(x->call.function) == ir_function_name(y->call.function) &&
+				x->call.arg_start == y->call.arg_start &&
+				x->call.arg_count == y->call.arg_count);
+	case IR_JUMP:
+		return x->target.then_block == y->target.then_block;
+	case IR_BRANCH:
+		return (x->target.then_block == y->target.then_block &&
+				x->target.else_block == y->target.else_block);
+	default:
+		return true;
+	}
+}
+
+static bool functions_equal(IrFunction* x, IrFunction* y) {
+	if (ir_function_name(x->decl) != ir_function_name(y->decl) ||
+		x->param_count != y->param_count ||
+		buf_len(x->locals) != buf_len(y->locals) ||
+		buf_len(x->reg_types) != buf_len(y->reg_types) ||
+		buf_len(x->instrs) != buf_len(y->instrs) ||
+		buf_len(x->blocks) != buf_len(y->blocks) ||
+		buf_len(x->block_order) != buf_len(y->block_order) ||
+		buf_len(x->args) != buf_len(y->args)) {
+		return false;
+	}
+	buf_loop(x->locals, l) {
+		if (x->locals[l].type != y->locals[l].type ||
+			x->locals[l].name != y->locals[l].name) {
+			return false;
+		}
+	}
+	buf_loop(x->reg_types, r) {
+		if (x->reg_types[r] != y->reg_types[r]) {
+			return false;
+		}
+	}
+	buf_loop(x->instrs, i) {
+		if (!instrs_equal(&x->instrs[i], &y->instrs[i])) {
+			return false;
+		}
+	}
+	buf_loop(x->blocks, b) {
+		if (x->blocks[b].first != y->blocks[b].first ||
+			x->blocks[b].count != y->blocks[b].count ||
+			x->block_order[b] != y->block_order[b]) {
+			return false;
+		}
+	}
+	buf_loop(x->args, a) {
+		if (x->args[a] != y->args[a]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ir_check(IrUnit* unit, Stmt** stmts) {
+	buf_loop(unit->functions, f) {
+		if (!check_function(&unit->functions[f])) {
+			return false;
+		}
+	}
+
+	IrPrinter printer;
+	char* text = printer.print(unit);
+	buf_push(text, '\0');
+	IrParser parser;
+	IrUnit* parsed = parser.parse(stmts, text);
+	if (!parsed) {
+		buf_free(text);
+		return false;
+	}
+
+	bool equal = buf_len(unit->functions) == buf_len(parsed->functions);
+	buf_loop(unit->functions, f) {
+		if (equal && !functions_equal(&unit->functions[f], &parsed->functions[f])) {
+			check_error(&unit->functions[f], "differs once printed and parsed");
+			equal = false;
+		}
+	}
+	if (equal) {
+		IrPrinter reprinter;
+		char* retext = reprinter.print(parsed);
+		buf_push(retext, '\0');
+		if (strcmp(text, retext) != 0) {
+			fprintf(stderr, "ir: prints differently once parsed\n");
+			equal = false;
+		}
+		buf_free(retext);
+	}
+
+	ir_free(parsed);
+	buf_free(text);
+	return equal;
+}
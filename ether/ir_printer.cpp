@@ -0,0 +1,155 @@
+#include <ir_printer.hpp>
+#include <stmt.hpp>
+#include <token.hpp>
+#include <data_type.hpp>
+
+char* IrPrinter::print(IrUnit* unit) {
+	text = null;
+	buf_loop(unit->functions, f) {
+		if (f != 0) {
+			print_char('\n');
+		}
+		print_function(&unit->functions[f]);
+	}
+	return text;
+}
+
+/* func @name params N, then a line per local, then the blocks in
+ * layout order */
+void IrPrinter::print_function(IrFunction* function) {
+	print_string("func @");
+	print_string(ir_function_name(function->decl));
+	print_string(" params ");
+	print_u64(function->param_count);
+	print_char('\n');
+
+	buf_loop(function->locals, l) {
+		print_string("\t$");
+		print_u64(l);
+		print_char(' ');
+		print_data_type(function->locals[l].type);
+		print_char(' ');
+		print_string(function->locals[l].name ? function->locals[l].name : "-");
+		print_char('\n');
+	}
+
+	buf_loop(function->block_order, o) {
+		u32 block = function->block_order[o];
+		print_block(block);
+		print_string(":\n");
+		IrBlock* ir_block = &function->blocks[block];
+		for (u32 i = ir_block->first; i < ir_block->first + ir_block->count; ++i) {
+			print_char('\t');
+			print_instr(function, &function->instrs[i]);
+			print_char('\n');
+		}
+	}
+}
+
+void IrPrinter::print_instr(IrFunction* function, IrInstr* instr) {
+	if (instr->dst != IR_NO_REG) {
+		print_reg(instr->dst);
+		print_char(' ');
+		print_data_type(function->reg_types[instr->dst]);
+		print_string(" = ");
+	}
+	print_string(ir_op_name(instr->op));
+	if (instr->type) {
+		print_char(' ');
+		print_data_type(instr->type);
+	}
+
+	switch (instr->op) {
+	case IR_CONST:
+		print_char(' ');
+		if (instr->type->pointer_count == 0 &&
+			(instr->type == data_types.t_f32 || instr->type == data_types.t_f64)) {
+			double value;
+			memcpy(&value, &instr->imm, sizeof(value));
+			buf_printf(text, "%.17g", value);
+		}
+		else {
+			print_u64(instr->imm);
+		}
+		break;
+	case IR_STRING:
+		print_string(" \"");
+		print_string(instr->str);
+		print_char('"');
+		break;
+	case IR_GLOBAL:
+		print_string(" @");
+		print_string(instr->stmt->var_decl.identifier->lexeme);
+		break;
+	case IR_LOCAL:
+		print_string(" $");
+		print_u64(instr->imm);
+		break;
+	case IR_FIELD:
+		print_char(' ');
+		print_reg(instr->a);
+		print_string(", ");
+		print_string(instr->stmt->var_decl.identifier->lexeme);
+		break;
+	case IR_CALL:
+		print_string(" @");
+		print_string(ir_function_name(instr->call.function));
+		print_char('(');
+		for (u32 a = 0; a < instr->call.arg_count; ++a) {
+			if (a != 0) {
+				print_string(", ");
+			}
+			print_reg(function->args[instr->call.arg_start + a]);
+		}
+		print_char(')');
+		break;
+	case IR_JUMP:
+		print_char(' ');
+		print_block(instr->target.then_block);
+		break;
+	case IR_BRANCH:
+		print_char(' ');
+		print_reg(instr->a);
+		print_string(", ");
+		print_block(instr->target.then_block);
+		print_string(", ");
+		print_block(instr->target.else_block);
+		break;
+	default:
+		if (instr->a != IR_NO_REG) {
+			print_char(' ');
+			print_reg(instr->a);
+		}
+		if (instr->b != IR_NO_REG) {
+			print_string(", ");
+			print_reg(instr->b);
+		}
+		break;
+	}
+}
+
+void IrPrinter::print_data_type(DataType* data_type) {
+	print_string(data_type_to_string(data_type));
+}
+
+void IrPrinter::print_reg(u32 reg) {
+	print_char('%');
+	print_u64(reg);
+}
+
+void IrPrinter::print_block(u32 block) {
+	print_string("bb");
+	print_u64(block);
+}
+
+void IrPrinter::print_string(const char* str) {
+	buf_printf(text, "%s", str);
+}
+
+void IrPrinter::print_char(char c) {
+	buf_push(text, c);
+}
+
+void IrPrinter::print_u64(u64 n) {
+	buf_printf(text, "%lu", n);
+}
@@ -1,6 +1,11 @@
 #include <ether.hpp>
+#include <token.hpp>
 
-char* keywords[KEYWORDS_LEN] = {
+#define KEYWORD_TABLE_BITS 5
+#define KEYWORD_TABLE_SIZE (1 << KEYWORD_TABLE_BITS)
+
+/* indexed by KeywordType */
+static constexpr const char* keyword_literals[KEYWORDS_LEN] = {
 	"import",
 	"struct",
 	"extern",
@@ -16,3 +21,86 @@ char* keywords[KEYWORDS_LEN] = {
 	"false",
 	"null",
 };
+
+/* interned by sys_keywords_init, so lexemes can be compared by pointer */
+char* keywords[KEYWORDS_LEN];
+
+struct KeywordTable {
+	u32 seed;
+	u64 min_len;
+	u64 max_len;
+	i8 slots[KEYWORD_TABLE_SIZE];
+};
+
+static constexpr u64 keyword_literal_len(const char* str) {
+	u64 len = 0;
+	while (str[len]) len++;
+	return len;
+}
+
+/* keyed only on the length and the first and last characters,
+ * so classifying an identifier never looks at the rest of it */
+static constexpr u32 keyword_hash(u32 seed, u64 len, char first, char last) {
+	u32 h = seed;
+	h = (h ^ (u32)len) * 0x9e3779b1;
+	h = (h ^ (u8)first) * 0x85ebca6b;
+	h = (h ^ (u8)last) * 0xc2b2ae35;
+	return h >> (32 - KEYWORD_TABLE_BITS);
+}
+
+static constexpr KeywordTable keyword_table_generate() {
+	KeywordTable table = {};
+	table.min_len = keyword_literal_len(keyword_literals[0]);
+	for (u64 i = 0; i < KEYWORDS_LEN; i++) {
+		u64 len = keyword_literal_len(keyword_literals[i]);
+		if (len < table.min_len) table.min_len = len;
+		if (len > table.max_len) table.max_len = len;
+	}
+
+	for (u32 seed = 1; seed != 0; seed++) {
+		for (u64 s = 0; s < KEYWORD_TABLE_SIZE; s++) {
+			table.slots[s] = KW_NONE;
+		}
+
+		bool collision = false;
+		for (u64 i = 0; i < KEYWORDS_LEN && !collision; i++) {
+			const char* keyword = keyword_literals[i];
+			u64 len = keyword_literal_len(keyword);
+			u32 h = keyword_hash(seed, len, keyword[0], keyword[len - 1]);
+			if (table.slots[h] != KW_NONE) {
+				collision = true;
+			}
+			table.slots[h] = (i8)i;
+		}
+
+		if (!collision) {
+			table.seed = seed;
+			return table;
+		}
+	}
+	return table;
+}
+
+static constexpr KeywordTable keyword_table = keyword_table_generate();
+static_assert(keyword_table.seed != 0, "no perfect hash seed found for keywords");
+
+void sys_keywords_init() {
+	for (u64 i = 0; i < KEYWORDS_LEN; i++) {
+		keywords[i] = str_intern(const_cast<char*>(keyword_literals[i]));
+	}
+}
+
+KeywordType keyword_lookup(char* lexeme, u64 len) {
+	if (len < keyword_table.min_len || len > keyword_table.max_len) {
+		return KW_NONE;
+	}
+
+	i8 slot = keyword_table.slots[keyword_hash(keyword_table.seed,
+											   len,
+											   lexeme[0],
+											   lexeme[len - 1])];
+	if (slot != KW_NONE && keywords[slot] == lexeme) {
+		return (KeywordType)slot;
+	}
+	return KW_NONE;
+}
@@ -1,20 +1,19 @@
 #include <ether.hpp>
 #include <lexer.hpp>
+#include <scan.hpp>
 
 LexerOutput Lexer::lex(SourceFile* _srcfile) {
 	srcfile = _srcfile;
 	
 	tokens = null;
 	error_count = 0;
+	build_line_table(srcfile);
 	
 	start = srcfile->contents;
 	current = start;
-	line = 1;
+	end = srcfile->contents + srcfile->len;
 	
-	last_newline = srcfile->contents;
-	last_to_last_newline = null;
-	
-	for (current = srcfile->contents; current != (srcfile->contents + srcfile->len);) {
+	for (current = srcfile->contents; current < end;) {
 		start = current;
 		switch (*current) {
 		case '<': {
@@ -147,13 +146,10 @@ LexerOutput Lexer::lex(SourceFile* _srcfile) {
 			break;
 
 		case '\n':
-			newline();
-			break;
-
 		case '\t':
 		case '\r':
 		case ' ':
-			current++;
+			current = skip_whitespace(current + 1);
 			break;
 
 		default: 
@@ -173,40 +169,31 @@ LexerOutput Lexer::lex(SourceFile* _srcfile) {
 }
 
 void Lexer::identifier() {
-	TokenType type = T_IDENTIFIER;
-	current++;
-	while (isalnum(*current) || *current == '_') {
-		current++;
-	}
+	current = skip_identifier(current + 1);
 
-	char* lexed_identifier = str_intern_range(start, current);
-	for (u64 kw_idx = 0; kw_idx < KEYWORDS_LEN; ++kw_idx) {
-		char* keyword = keywords[kw_idx];
-		if (lexed_identifier ==
-			str_intern(keyword)) {
-			type = T_KEYWORD;
-		}
+	add_in(T_IDENTIFIER);
+	Token* token = buf_end(tokens) - 1;
+	token->keyword = keyword_lookup(token->lexeme, token->char_count);
+	if (token->keyword != KW_NONE) {
+		token->type = T_KEYWORD;
 	}
-
-	add_in(type);
 }
 
 void Lexer::number() {
-	u64 number_start_line = line;
-	u64 number_start_column = compute_column_on_current();
+	char* number_start = current;
 	TokenType type = T_INTEGER;
-	while (isdigit(*current)) {
+	while (is_char_class(*current, CC_DIGIT)) {
 		current++;
 	}
 
 	if (*current == '.') {
 		current++;
-		if (!isdigit(*current)) {
+		if (!is_char_class(*current, CC_DIGIT)) {
 			error("expect numeral literal after ‘.’;");
 		}
 
 		type = T_FLOAT64;
-		while (isdigit(*current)) {
+		while (is_char_class(*current, CC_DIGIT)) {
 			current++;
 		}
 	}
@@ -215,8 +202,7 @@ void Lexer::number() {
 		u64 converted_value = strtoul(str_intern_range(start, current), null, 10);
 		if (converted_value == ULONG_MAX && errno == ERANGE) {
 			warning_at_rng(
-					number_start_line, 
-					number_start_column, 
+					number_start,
 					(current - start), 
 					"integer overflow; value will be wrapped;");
 		}
@@ -226,28 +212,30 @@ void Lexer::number() {
 }
 
 void Lexer::string() {
-	u64 quote_line = line;
-	u64 quote_column = compute_column();
+	char* quote = start;
 
 	start++;	// don't include the double quotes
-	current++;
-	while (*current != '"') {
-		if (is_at_end()) {
-			error_at(quote_line,
-					 quote_column,
-					 "missing terminating ‘\"’;");
-			return;
-		}
-		current++;
+	current = skip_string_body(current + 1);
+	if (is_at_end()) {
+		error_at(quote,
+				 "missing terminating ‘\"’;");
+		return;
 	}
 
 	add_in(T_STRING);
 	current++;
 }
 
+/* errors at the end of input are reported at the opening quote or
+ * backslash, since current is then past the last character */
 void Lexer::chr() {
+	char* quote = start;
 	start++;	// don't include the double quotes
 	current++;
+	if (is_at_end()) {
+		error_at(quote, "missing terminating ‘'’;");
+		return;
+	}
 
 	if (*current == '\\') {
 		escape_chars();
@@ -256,6 +244,10 @@ void Lexer::chr() {
 		current++;
 	}
 
+	if (is_at_end()) {
+		error_at(quote, "missing terminating ‘'’;");
+		return;
+	}
 	if (*current != '\'') {
 		error("char literals can only hold a single character;");
 		return;
@@ -265,15 +257,12 @@ void Lexer::chr() {
 	current++;
 }
 
-void Lexer::newline() {
-	last_to_last_newline = last_newline;
-	last_newline = current;
-	line++;
-	current++;
-}
-
+/* at the end of input chr reports the missing quote */
 void Lexer::escape_chars() {
 	current++;
+	if (is_at_end()) {
+		return;
+	}
 	switch (*current) {
 	case '\'':
 	case '"':
@@ -292,6 +281,10 @@ void Lexer::escape_chars() {
 
 void Lexer::backslash() {
 	current++;
+	if (is_at_end()) {
+		error_at(start, "missing escape character;");
+		return;
+	}
 	switch (*current) {
 	case ' ':
 	case '\n':
@@ -308,18 +301,16 @@ void Lexer::backslash() {
 }
 
 bool Lexer::match(char c) {
-	if (!is_at_end() && current < (srcfile->contents + srcfile->len)) {
-		if (*(current + 1) == c) {
-			current++;
-			return true;
-		}
+	/* current + 1 is at worst the first padding byte */
+	if (!is_at_end() && *(current + 1) == c) {
+		current++;
+		return true;
 	}
 	return false;
 }
 
 bool Lexer::is_at_end() {
-	if (current >= (srcfile->contents + srcfile->len) ||
-		*current == '\0') {
+	if (current >= end || *current == '\0') {
 		return true;
 	}
 	return false;
@@ -331,75 +322,46 @@ void Lexer::add(TokenType type) {
 }
 
 void Lexer::add_in(TokenType type) {
-	buf_push(tokens, token_create(
-				 str_intern_range(start, current),
-				 start,
-				 current,
-				 type,
-				 srcfile,
-				 line, 
-				 compute_column(),
-				 current - start));
+	Token token;
+	token.lexeme = str_intern_range(start, current);
+	token.offset = compute_offset(start);
+	token.char_count = current - start;
+	token.file_id = srcfile->id;
+	token.type = type;
+	token.keyword = KW_NONE;
+	buf_push(tokens, token);
 }
 
 void Lexer::add_eof() {
-	Token* last_token = null;
-	char* eof_string = "*EOF*";
-	if (!buf_empty(tokens)) {
-		last_token = buf_last(tokens);
-		buf_push(tokens, token_create(
-					 eof_string,
-					 last_token->end,
-					 last_token->end,
-					 T_EOF,
-					 srcfile,
-					 last_token->line, 
-					 last_token->column +
-					 last_token->char_count,
-					 1));
-	}
-	
-	else {
-		buf_push(tokens, token_create(
-					 eof_string,
-					 null,
-					 null,
-					 T_EOF,
-					 srcfile,
-					 1,
-					 1,
-					 1));
+	Token eof;
+	eof.lexeme = names.eof;
+	eof.offset = 0;
+	eof.char_count = 1;
+	eof.file_id = srcfile->id;
+	eof.type = T_EOF;
+	eof.keyword = KW_NONE;
+	if (buf_len(tokens) != 0) {
+		eof.offset = token_end(buf_end(tokens) - 1);
 	}
+	buf_push(tokens, eof);
 }
 
-u64 Lexer::compute_column() {
-	u64 column = start - last_newline;
-	if (line == 1) {
-		column++;
-	}
-	return column;
-}
-
-u64 Lexer::compute_column_on_current() {
-	u64 column = current - last_newline;
-	if (line == 1) {
-		column++;
-	}
-	return column;
+u64 Lexer::compute_offset(char* c) {
+	return c - srcfile->contents;
 }
 
 void Lexer::error(const char* fmt, ...) {
 	va_list ap;
 	va_start(ap, fmt);
-	print_error_at(srcfile, line, compute_column_on_current(), 1, fmt, ap);
+	print_error_at(srcfile, compute_offset(current), 1, fmt, ap);
 	va_end(ap);
 	error_count++;
 }
 
-void Lexer::error_at(u64 _line, u64 _column, const char* fmt, ...) {
+void Lexer::error_at(char* c, const char* fmt, ...) {
 	va_list ap;
 	va_start(ap, fmt);
-	print_error_at(srcfile, _line, _column, 1, fmt, ap);
+	print_error_at(srcfile, compute_offset(c), 1, fmt, ap);
 	va_end(ap);
 	error_count++;
 }
@@ -407,20 +369,20 @@ void Lexer::error_at(u64 _line, u64 _column, const char* fmt, ...) {
 void Lexer::warning(const char* fmt, ...) {
 	va_list ap;
 	va_start(ap, fmt);
-	print_warning_at(srcfile, line, compute_column_on_current(), 1, fmt, ap);
+	print_warning_at(srcfile, compute_offset(current), 1, fmt, ap);
 	va_end(ap);
 }
 
-void Lexer::warning_at(u64 _line, u64 _column, const char* fmt, ...) {
+void Lexer::warning_at(char* c, const char* fmt, ...) {
 	va_list ap;
 	va_start(ap, fmt);
-	print_warning_at(srcfile, _line, _column, 1, fmt, ap);
+	print_warning_at(srcfile, compute_offset(c), 1, fmt, ap);
 	va_end(ap);
 }
 
-void Lexer::warning_at_rng(u64 _line, u64 _column, u64 mark_len, const char* fmt, ...) {
+void Lexer::warning_at_rng(char* c, u64 mark_len, const char* fmt, ...) {
 	va_list ap;
 	va_start(ap, fmt);
-	print_warning_at(srcfile, _line, _column, mark_len, fmt, ap);
+	print_warning_at(srcfile, compute_offset(c), mark_len, fmt, ap);
 	va_end(ap);
 }
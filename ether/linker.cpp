@@ -4,6 +4,8 @@
 #include <expr.hpp>
 #include <data_type.hpp>
 #include <token.hpp>
+#include <profile.hpp>
+#include <stats.hpp>
 
 #define error_expr(e, fmt, ...) error_expr(this, e, fmt, ##__VA_ARGS__)
 #define error_data_type(d, fmt, ...) error_data_type(this, d, fmt, ##__VA_ARGS__)
@@ -13,24 +15,14 @@
 #define warning_data_type(d, fmt, ...) warning_data_type(this, d, fmt, ##__VA_ARGS__)
 #define warning_token(t, fmt, ...) warning_token(this, t, fmt, ##__VA_ARGS__)
 
-#define CHANGE_SCOPE(name)						\
-	Scope* name = new Scope;					\
-	scope->parent_scope = current_scope;		\
-	scope->variables = null;					\
-	current_scope = name;						\
-
-#define REVERT_SCOPE(name)						\
-	current_scope = name->parent_scope;
-
 error_code Linker::link(Stmt** _stmts) {
 	stmts = _stmts;
 	
-	defined_structs = null;
-	defined_functions = null;
-	global_scope = new Scope;
-	global_scope->parent_scope = null;
-	global_scope->variables = null;
-	current_scope = global_scope;
+	defined_structs = {};
+	defined_functions = {};
+	variables = null;
+	scope_starts = null;
+	variable_map = {};
 	function_in = null;
 	error_count = 0;
 
@@ -40,6 +32,17 @@ error_code Linker::link(Stmt** _stmts) {
 
 	check_stmts();
 
+	assert(buf_len(scope_starts) == 0);
+	profile_memory(MEM_SCOPES,
+				   buf_cap(variables) * sizeof(ScopeVariable) +
+				   buf_cap(scope_starts) * sizeof(u64) +
+				   variable_map.cap * 2 * sizeof(u64));
+	buf_free(variables);
+	buf_free(scope_starts);
+	map_free(&variable_map);
+	free_structs();
+	map_free(&defined_functions);
+
 	return (error_count == 0 ?
 			ETHER_SUCCESS :
 			ETHER_ERROR);
@@ -54,30 +57,37 @@ void Linker::add_structs() {
 }
 
 void Linker::add_struct(Stmt* stmt) {
-	buf_loop(defined_structs, i) {
-		for (u64 bt = 0; bt < BUILT_IN_TYPES_LEN; bt++) {
-			if (str_intern(stmt->struct_stmt.identifier->lexeme) ==
-				str_intern(built_in_types[bt])) {
-				error_token(stmt->struct_stmt.identifier,
-							"redeclaration of built-in type ‘%s’ as a struct;",
-							built_in_types[bt]);
-				return;
-			}
-		}
-		
-		if (is_token_equal(stmt->struct_stmt.identifier,
-						   defined_structs[i]->stmt->struct_stmt.identifier)) {
-			error_token(stmt->struct_stmt.identifier,
-						"redeclaration of struct ‘%s’;",
-						stmt->struct_stmt.identifier->lexeme);
-			return;
-		}
+	if (is_built_in_type(stmt->struct_stmt.identifier->lexeme)) {
+		error_token(stmt->struct_stmt.identifier,
+					"redeclaration of built-in type ‘%s’ as a struct;",
+					stmt->struct_stmt.identifier->lexeme);
+		return;
+	}
+	
+	if (map_get(&defined_structs, stmt->struct_stmt.identifier->lexeme)) {
+		error_token(stmt->struct_stmt.identifier,
+					"redeclaration of struct ‘%s’;",
+					stmt->struct_stmt.identifier->lexeme);
+		return;
 	}
 
 	StructFunctionMap* map = new StructFunctionMap;
 	map->stmt = stmt;
 	map->functions = null;
-	buf_push(defined_structs, map);
+	map->function_map = {};
+	map_put(&defined_structs, stmt->struct_stmt.identifier->lexeme, map);
+}
+
+void Linker::free_structs() {
+	for (u64 i = 0; i < defined_structs.cap; i++) {
+		if (defined_structs.keys[i]) {
+			StructFunctionMap* map = (StructFunctionMap*)defined_structs.vals[i];
+			buf_free(map->functions);
+			map_free(&map->function_map);
+			delete map;
+		}
+	}
+	map_free(&defined_structs);
 }
 
 void Linker::add_functions() {
@@ -95,87 +105,80 @@ void Linker::add_functions() {
 
 void Linker::add_function_global(Stmt* stmt) {
 	bool error_here = false;
-	buf_loop(defined_functions, i) {
-		if (is_token_equal(stmt->func_decl.identifier,
-						   defined_functions[i]->func_decl.identifier)) {
-			if (!stmt->func_decl.is_function &&
-				!defined_functions[i]->func_decl.is_function) {
-				DataTypeMatch match =
-					data_type_match(stmt->func_decl.return_data_type,
-									defined_functions[i]->func_decl.return_data_type);
-				if (match != DT_MATCH) {
-					error_data_type(stmt->func_decl.return_data_type,
-									"extern function conflicts from previous declaration (return type conflict);");
-					error_here = true;
-				}
+	Stmt* previous = (Stmt*)map_get(&defined_functions, stmt->func_decl.identifier->lexeme);
+	if (previous) {
+		if (!stmt->func_decl.is_function &&
+			!previous->func_decl.is_function) {
+			DataTypeMatch match =
+				data_type_match(stmt->func_decl.return_data_type,
+								previous->func_decl.return_data_type);
+			if (match != DT_MATCH) {
+				error_data_type(stmt->func_decl.return_data_type,
+								"extern function conflicts from previous declaration (return type conflict);");
+				error_here = true;
+			}
 
-				u64 current_stmt_param_count = buf_len(stmt->func_decl.params);
-				u64 previous_stmt_param_count = buf_len(defined_functions[i]->func_decl.params);
-				bool arity_error = false;
-				if (current_stmt_param_count != previous_stmt_param_count) {
-					error_token(stmt->func_decl.identifier,
-								"extern function conflicts from previous declaration (parameter count conflict);");
-					error_here = true;
-					arity_error = true;
-				}
+			u64 current_stmt_param_count = buf_len(stmt->func_decl.params);
+			u64 previous_stmt_param_count = buf_len(previous->func_decl.params);
+			bool arity_error = false;
+			if (current_stmt_param_count != previous_stmt_param_count) {
+				error_token(stmt->func_decl.identifier,
+							"extern function conflicts from previous declaration (parameter count conflict);");
+				error_here = true;
+				arity_error = true;
+			}
 
-				Stmt** current_decl_params = stmt->func_decl.params;
-				Stmt** previous_decl_params = defined_functions[i]->func_decl.params;
-				if (!arity_error) {
-					buf_loop(current_decl_params, cp) {
-						if (!is_token_equal(current_decl_params[cp]->var_decl.identifier,
-											previous_decl_params[cp]->var_decl.identifier)) {
-							error_token(current_decl_params[cp]->var_decl.identifier,
-										"extern function conflicts from previous declaration (parameter name conflict);");
-							error_here = true;
-						}
-						
-						DataTypeMatch param_match =
-							data_type_match(current_decl_params[cp]->var_decl.data_type,
-											previous_decl_params[cp]->var_decl.data_type);
-						if (param_match != DT_MATCH) {
-							error_data_type(current_decl_params[cp]->var_decl.data_type,
-											"extern function conflicts from previous declaration (parameter data type conflict);");
-							error_here = true;
-						}
+			Stmt** current_decl_params = stmt->func_decl.params;
+			Stmt** previous_decl_params = previous->func_decl.params;
+			if (!arity_error) {
+				buf_loop(current_decl_params, cp) {
+					if (!is_token_equal(current_decl_params[cp]->var_decl.identifier,
+										previous_decl_params[cp]->var_decl.identifier)) {
+						error_token(current_decl_params[cp]->var_decl.identifier,
+									"extern function conflicts from previous declaration (parameter name conflict);");
+						error_here = true;
+					}
+					
+					DataTypeMatch param_match =
+						data_type_match(current_decl_params[cp]->var_decl.data_type,
+										previous_decl_params[cp]->var_decl.data_type);
+					if (param_match != DT_MATCH) {
+						error_data_type(current_decl_params[cp]->var_decl.data_type,
+										"extern function conflicts from previous declaration (parameter data type conflict);");
+						error_here = true;
 					}
 				}
 			}
-			else {
-				error_token(stmt->func_decl.identifier,
-							"redefinition of function ‘%s’;",
-							stmt->func_decl.identifier->lexeme);
-				return;
-			}
+		}
+		else {
+			error_token(stmt->func_decl.identifier,
+						"redefinition of function ‘%s’;",
+						stmt->func_decl.identifier->lexeme);
+			return;
 		}
 	}
 
-	if (error_here) return;
+	if (error_here || previous) return;
 
-	buf_push(defined_functions, stmt);
+	map_put(&defined_functions, stmt->func_decl.identifier->lexeme, stmt);
 }
 
 void Linker::add_function_struct(Stmt* stmt) {
-	u64 idx = 0;
-	buf_loop(defined_structs, i) {
-		if (stmt->func_decl.struct_in ==
-			defined_structs[i]->stmt) {
-			idx = i;
-			break;
-		}
-	}
-
-	buf_loop(defined_structs[idx]->functions, f) {
-		if (is_token_equal(stmt->func_decl.identifier,
-						   defined_structs[idx]->functions[f]->func_decl.identifier)) {
-			error_token(stmt->func_decl.identifier,
-						"redefinition of struct function ‘%s’;",
-						stmt->func_decl.identifier->lexeme);
-			return;
-		}
+	StructFunctionMap* map =
+		(StructFunctionMap*)map_get(&defined_structs,
+									stmt->func_decl.struct_in->struct_stmt.identifier->lexeme);
+	/* a redeclared struct has already been reported */
+	if (!map || map->stmt != stmt->func_decl.struct_in) return;
+
+	if (map_get(&map->function_map, stmt->func_decl.identifier->lexeme)) {
+		error_token(stmt->func_decl.identifier,
+					"redefinition of struct function ‘%s’;",
+					stmt->func_decl.identifier->lexeme);
+		return;
 	}
 
-	buf_push(defined_structs[idx]->functions, stmt);
+	map_put(&map->function_map, stmt->func_decl.identifier->lexeme, stmt);
+	buf_push(map->functions, stmt);
 }
 
 void Linker::add_variables() {
@@ -188,27 +191,26 @@ void Linker::add_variables() {
 
 void Linker::add_variable(Stmt* stmt) {
 	bool error_here = false;
-	buf_loop(global_scope->variables, i) {
-		if (is_token_equal(stmt->var_decl.identifier,
-						   global_scope->variables[i]->var_decl.identifier)) {
-			if (!stmt->var_decl.is_variable &&
-				!global_scope->variables[i]->var_decl.is_variable) {
-				DataTypeMatch match =
-					data_type_match(stmt->var_decl.data_type,
-									global_scope->variables[i]->var_decl.data_type);
-				if (match != DT_MATCH) {
-					error_token(stmt->var_decl.identifier,
-								"extern variable conflicts from previous declaration;");
-					error_here = true;
-				}
-			}
-			else {
+	ScopeVariable* found = find_variable(stmt->var_decl.identifier);
+	Stmt* previous = (found ? found->stmt : null);
+	if (previous) {
+		if (!stmt->var_decl.is_variable &&
+			!previous->var_decl.is_variable) {
+			DataTypeMatch match =
+				data_type_match(stmt->var_decl.data_type,
+								previous->var_decl.data_type);
+			if (match != DT_MATCH) {
 				error_token(stmt->var_decl.identifier,
-							"redeclaration of variable ‘%s’;",
-							stmt->var_decl.identifier->lexeme);
-				return;
+							"extern variable conflicts from previous declaration;");
+				error_here = true;
 			}
 		}
+		else {
+			error_token(stmt->var_decl.identifier,
+						"redeclaration of variable ‘%s’;",
+						stmt->var_decl.identifier->lexeme);
+			return;
+		}
 	}
 	
 	if (error_here) return;
@@ -217,12 +219,16 @@ void Linker::add_variable(Stmt* stmt) {
 		check_expr(stmt->var_decl.initializer);
 	}
 
-	buf_push(global_scope->variables, stmt);
+	if (!previous) {
+		push_variable(stmt);
+	}
 }
 
 void Linker::check_stmts() {
 	buf_loop(stmts, s) {
+		ProfileMark mark = profile_stmt_begin();
 		check_stmt(stmts[s]);
+		profile_stmt_end(mark, PHASE_LINK, stmts[s]);
 	}
 }
 
@@ -263,7 +269,7 @@ void Linker::check_stmt(Stmt* stmt) {
 }
 
 void Linker::check_struct(Stmt* stmt) {
-	CHANGE_SCOPE(scope);
+	enter_scope();
 	
 	Stmt** fields = stmt->struct_stmt.fields;
 	buf_loop(fields, f) {
@@ -276,16 +282,15 @@ void Linker::check_struct(Stmt* stmt) {
 		else if (scope_in_found == VS_OUTER_SCOPE) {
 			warning_token(fields[f]->var_decl.identifier,
 						  "variable declaration shadows another variable;");
-			buf_push(scope->variables, fields[f]);
 		}
-		buf_push(scope->variables, fields[f]);
+		push_variable(fields[f]);
 	}
 
 	Stmt** functions = null;
-	buf_loop(defined_structs, s) {
-		if (defined_structs[s]->stmt == stmt) {
-			functions = defined_structs[s]->functions;
-		}
+	StructFunctionMap* map =
+		(StructFunctionMap*)map_get(&defined_structs, stmt->struct_stmt.identifier->lexeme);
+	if (map && map->stmt == stmt) {
+		functions = map->functions;
 	}
 
 	buf_loop(functions, f) {
@@ -294,11 +299,11 @@ void Linker::check_struct(Stmt* stmt) {
 		check_func_decl(functions[f]);
 	}
 	
-	REVERT_SCOPE(scope);
+	exit_scope();
 }
 
 void Linker::check_func_decl(Stmt* stmt) {
-	CHANGE_SCOPE(scope);
+	enter_scope();
 	function_in = stmt;
 	buf_loop(stmt->func_decl.params, p) {
 		Stmt** params = stmt->func_decl.params;
@@ -315,7 +320,7 @@ void Linker::check_func_decl(Stmt* stmt) {
 		}
 	}
 	function_in = null;
-	REVERT_SCOPE(scope);
+	exit_scope();
 }
 
 void Linker::check_var_decl(Stmt* stmt) {
@@ -343,18 +348,18 @@ void Linker::check_if_stmt(Stmt* stmt) {
 }
 
 void Linker::check_if_branch(IfBranch* branch) {
-	CHANGE_SCOPE(scope);
+	enter_scope();
 	if (branch->cond) {
 		check_expr(branch->cond);
 	}
 	buf_loop(branch->body, s) {
 		check_stmt(branch->body[s]);
 	}
-	REVERT_SCOPE(scope);
+	exit_scope();
 }
 
 void Linker::check_for_stmt(Stmt* stmt) {
-	CHANGE_SCOPE(scope);
+	enter_scope();
 	if (stmt->for_stmt.counter) {
 		check_var_decl(stmt->for_stmt.counter);
 	}
@@ -365,7 +370,7 @@ void Linker::check_for_stmt(Stmt* stmt) {
 	buf_loop(stmt->for_stmt.body, s) {
 		check_stmt(stmt->for_stmt.body[s]);
 	}
-	REVERT_SCOPE(scope);
+	exit_scope();
 }
 
 void Linker::check_switch_stmt(Stmt* stmt) {
@@ -391,11 +396,11 @@ void Linker::check_return_stmt(Stmt* stmt) {
 }
 
 void Linker::check_block_stmt(Stmt* stmt) {
-	CHANGE_SCOPE(scope);
+	enter_scope();
 	buf_loop(stmt->block, s) {
 		check_stmt(stmt->block[s]);
 	}
-	REVERT_SCOPE(scope);
+	exit_scope();
 }
 
 void Linker::check_expr_stmt(Stmt* stmt) {
@@ -419,6 +424,9 @@ void Linker::check_expr(Expr* expr) {
 	case E_ARRAY_ACCESS:
 		check_array_access(expr);
 		break;
+	case E_MEMBER_ACCESS:
+		check_member_access(expr);
+		break;
 	case E_VARIABLE_REF:
 		check_variable_ref(expr);
 		break;
@@ -426,7 +434,6 @@ void Linker::check_expr(Expr* expr) {
 	case E_STRING:
 	case E_CHAR:
 	case E_CONSTANT:
-	case E_MEMBER_ACCESS:
 		break;	
 	}
 }
@@ -447,13 +454,9 @@ void Linker::check_cast_expr(Expr* expr) {
 
 void Linker::check_func_call(Expr* expr) {
 	if (expr->func_call.left->type == E_VARIABLE_REF) {
-		buf_loop(defined_functions, f) {
-			if (is_token_equal(expr->func_call.left->variable_ref.identifier,
-							   defined_functions[f]->func_decl.identifier)) {
-				expr->func_call.function_called = defined_functions[f];
-				break;
-			}
-		}
+		expr->func_call.function_called =
+			(Stmt*)map_get(&defined_functions,
+						   expr->func_call.left->variable_ref.identifier->lexeme);
 
 		if (!expr->func_call.function_called) {
 			error_expr(expr->func_call.left,
@@ -477,6 +480,11 @@ void Linker::check_func_call(Expr* expr) {
 			return;
 		}
 	}
+	else if (expr->func_call.left->type == E_MEMBER_ACCESS) {
+		/* struct functions are found by resolve, which knows the
+		 * type of the struct */
+		check_member_access(expr->func_call.left);
+	}
 	
 	buf_loop(expr->func_call.args, a) {
 		check_expr(expr->func_call.args[a]);
@@ -488,6 +496,10 @@ void Linker::check_array_access(Expr* expr) {
 	check_expr(expr->array_access.index);
 }
 
+void Linker::check_member_access(Expr* expr) {
+	check_expr(expr->member_access.left);
+}
+
 void Linker::check_variable_ref(Expr* expr) {
 	VariableScope scope_in_found = is_variable_ref_in_scope(expr);
 	if (scope_in_found == VS_NO_SCOPE) {
@@ -498,34 +510,15 @@ void Linker::check_variable_ref(Expr* expr) {
 }
 
 void Linker::check_data_type(DataType* data_type, bool is_return_data_type) {
-	if (str_intern(data_type->identifier->lexeme) ==
-		str_intern("void") &&
+	if (data_type->identifier->lexeme == names.void_type &&
 		!is_return_data_type) {
 		error_data_type(data_type,
 						"invalid use of ‘void’ data type;");
 		return;
 	}
 	
-	bool found = false;
-	buf_loop(defined_structs, i) {
-		if (is_token_equal(defined_structs[i]->stmt->struct_stmt.identifier,
-						   data_type->identifier)) {
-			found = true;
-			break;
-		}
-	}
-
-	if (!found) {
-		for (u64 i = 0; i < BUILT_IN_TYPES_LEN; ++i) {
-			if (str_intern(built_in_types[i]) ==
-				str_intern(data_type->identifier->lexeme)) {
-				found = true;
-				break;
-			}
-		}
-	}
-	
-	if (!found) {
+	if (!map_get(&defined_structs, data_type->identifier->lexeme) &&
+		!is_built_in_type(data_type->identifier->lexeme)) {
 		error_token(data_type->identifier,
 					"undefined type ‘%s’;",
 					data_type->identifier->lexeme);
@@ -542,80 +535,93 @@ void Linker::add_variable_to_scope(Stmt* stmt) {
 	else if (scope_in_found == VS_OUTER_SCOPE) {
 		warning_token(stmt->var_decl.identifier,
 					  "variable declaration shadows another variable;");
-		buf_push(current_scope->variables, stmt);
 	}
-	buf_push(current_scope->variables, stmt);
+	push_variable(stmt);
+}
+
+void Linker::push_variable(Stmt* stmt) {
+	ScopeVariable variable;
+	variable.stmt = stmt;
+	variable.depth = buf_len(scope_starts);
+	variable.slot = buf_len(variables) - (variable.depth ?
+										  buf_last(scope_starts) :
+										  0);
+	variable.shadowed = map_get_u64_from_u64(&variable_map,
+											 (u64)stmt->var_decl.identifier->lexeme);
+	buf_push(variables, variable);
+	map_put_u64_from_u64(&variable_map,
+						 (u64)stmt->var_decl.identifier->lexeme,
+						 buf_len(variables));
+}
+
+void Linker::enter_scope() {
+	buf_push(scope_starts, buf_len(variables));
+}
+
+void Linker::exit_scope() {
+	assert(buf_len(scope_starts) != 0);
+	u64 start = buf_last(scope_starts);
+	/* unwind innermost first so every name gets back what it shadowed */
+	while (buf_len(variables) > start) {
+		ScopeVariable* variable = buf_end(variables) - 1;
+		u64 key = (u64)variable->stmt->var_decl.identifier->lexeme;
+		if (variable->shadowed) {
+			map_put_u64_from_u64(&variable_map, key, variable->shadowed);
+		}
+		else {
+			map_remove_u64(&variable_map, key);
+		}
+		buf_pop(variables);
+	}
+	buf_pop(scope_starts);
+}
+
+ScopeVariable* Linker::find_variable(Token* identifier) {
+	u64 idx = map_get_u64_from_u64(&variable_map, (u64)identifier->lexeme);
+	if (!idx) return null;
+	return &variables[idx - 1];
 }
 
 VariableScope Linker::is_variable_ref_in_scope(Expr* expr) {
-	VariableScope scope_in_found = VS_NO_SCOPE;
-	bool first_iter = true;
-	Scope* scope = current_scope;
-	
-	while (scope != null) {
-		buf_loop(scope->variables, v) {
-			if (is_token_equal(expr->variable_ref.identifier,
-							   scope->variables[v]->var_decl.identifier)) {
-				if (first_iter) {
-					scope_in_found = VS_CURRENT_SCOPE;										
-				}
-				else {
-					scope_in_found = VS_OUTER_SCOPE;
-				}
-				expr->variable_ref.variable_refed = scope->variables[v];
-				break;
-			}
-		}
-		
-		if (scope_in_found != VS_NO_SCOPE) break;
-		scope = scope->parent_scope;
-		first_iter = false;
+	ScopeVariable* variable = find_variable(expr->variable_ref.identifier);
+	STAT_INC(STAT_SCOPE_LOOKUPS);
+	if (!variable) {
+		STAT_INC(STAT_SCOPE_MISSES);
+		return VS_NO_SCOPE;
 	}
-	return scope_in_found;
+	STAT_ADD(STAT_SCOPE_DEPTH, buf_len(scope_starts) - variable->depth);
+
+	expr->variable_ref.variable_refed = variable->stmt;
+	expr->variable_ref.depth = variable->depth;
+	expr->variable_ref.slot = variable->slot;
+	return (variable->depth == buf_len(scope_starts) ?
+			VS_CURRENT_SCOPE :
+			VS_OUTER_SCOPE);
 }
 
 VariableScope Linker::is_variable_in_scope(Stmt* stmt) {
-	VariableScope scope_in_found = VS_NO_SCOPE;
-	bool first_iter = true;
-	Scope* scope = current_scope;
-
-	while (scope != null) {
-		buf_loop(scope->variables, v) {
-			if (is_token_equal(stmt->var_decl.identifier,
-							   scope->variables[v]->var_decl.identifier)) {
-				if (first_iter) {
-					scope_in_found = VS_CURRENT_SCOPE;
-				}
-				else {
-					scope_in_found = VS_OUTER_SCOPE;
-				}
-				break;
-			}
-		}
+	ScopeVariable* variable = find_variable(stmt->var_decl.identifier);
+	if (!variable) return VS_NO_SCOPE;
 
-		if (scope_in_found != VS_NO_SCOPE) break;
-		scope = scope->parent_scope;
-		first_iter = false;
-	}
-	return scope_in_found;
+	return (variable->depth == buf_len(scope_starts) ?
+			VS_CURRENT_SCOPE :
+			VS_OUTER_SCOPE);
 }
 
-void Linker::error_root(SourceFile* srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap) {
+void Linker::error_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
 	print_error_at(
 		srcfile,
-		line,
-		column,
+		offset,
 		char_count,
 		fmt,
 		ap);
 	error_count++;
 }
 
-void Linker::warning_root(SourceFile* srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap) {
+void Linker::warning_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
 	print_warning_at(
 		srcfile,
-		line,
-		column,
+		offset,
 		char_count,
 		fmt,
 		ap);
@@ -1,6 +1,5 @@
 #include <ether.hpp>
 #include <parser.hpp>
-#include <compiler.hpp>
 
 #include <string>
 
@@ -148,11 +147,12 @@
 		sync_to_next_statement();				\
 	} 
 
-#define STMT_CREATE(name) Stmt* name = new Stmt; 
+#define STMT_CREATE(name) Stmt* name = AST_NEW(ast_arena, AST_STMT, Stmt);
 
-ParserOutput Parser::parse(Token** _tokens, SourceFile* _srcfile) {
+ParserOutput Parser::parse(Token* _tokens, SourceFile* _srcfile, AstArena* _ast_arena) {
 	tokens = _tokens;
 	srcfile = _srcfile;
+	ast_arena = _ast_arena;
 	
 	stmts = null;
 	decls = null;
@@ -168,7 +168,7 @@ ParserOutput Parser::parse(Token** _tokens, SourceFile* _srcfile) {
 	error_lbrace_parsed = false;
 
 	current_struct = null;
-	pending_imports = null;
+	imports = null;
 	
 	while (current()->type != T_EOF) {
 		Stmt* stmt = decl_global();
@@ -180,6 +180,7 @@ ParserOutput Parser::parse(Token** _tokens, SourceFile* _srcfile) {
 	ParserOutput output;
 	output.stmts = stmts;
 	output.decls = decls;
+	output.imports = imports;
 	output.error_occured = (error_count > 0 ?
 							ETHER_ERROR :
 							ETHER_SUCCESS);
@@ -193,7 +194,7 @@ Stmt* Parser::decl_global() {
 	}
 
 	if (match_by_type(T_POUND)) {
-		if (match_keyword("import")) {
+		if (match_keyword(KW_IMPORT)) {
 			if (!match_by_type(T_STRING)) {
 				error("expect compile-time string literal;");
 				goto_next_token();
@@ -212,8 +213,8 @@ Stmt* Parser::decl_global() {
 														   last_slash :
 														   last_slash + 1));
 			current_dir.append(fpath_rel_file);
-			/* printf("FILE: %s\n", current_dir.c_str()); */
-			if (!file_exists(current_dir.c_str())) {
+			char* canonical_fpath = canonicalize_fpath(current_dir.c_str());
+			if (!canonical_fpath) {
 				dont_sync = true;
 				error_token(fpath_token,
 							"cannot find file; ");
@@ -222,9 +223,10 @@ Stmt* Parser::decl_global() {
 				return null;
 			}
 
-			// TODO: push output obj name
-			buf_push(pending_imports, str_intern(
-						 const_cast<char*>(current_dir.c_str())));
+			buf_push(imports, (ImportDecl){
+					str_intern(const_cast<char*>(current_dir.c_str())),
+					canonical_fpath,
+					fpath_token });
 			return null;
 		}
 		else {
@@ -233,7 +235,7 @@ Stmt* Parser::decl_global() {
 		}
 	}
 	
-	if (match_keyword("extern")) {
+	if (match_keyword(KW_EXTERN)) {
 		CONSUME_IDENTIFIER(identifier);
 		if (match_lparen()) {
 			// extern function
@@ -316,7 +318,7 @@ Stmt* Parser::decl(bool is_global) {
 				return null;
 			}
 
-			if (match_keyword("pub")) {
+			if (match_keyword(KW_PUB)) {
 				is_public_function = true;
 			}
 			
@@ -429,7 +431,7 @@ Stmt* Parser::decl(bool is_global) {
 			}
 		}
 	}
-	else if (match_keyword("struct")) {
+	else if (match_keyword(KW_STRUCT)) {
 		STMT_CREATE(stmt);
 		current_struct = stmt;
 		error_loc = STRUCT_HEADER;
@@ -484,13 +486,12 @@ Stmt* Parser::decl(bool is_global) {
 							 fields);
 	}
 	
-	else if (match_keyword("if") ||
-			 match_keyword("elif") ||
-			 match_keyword("else")) {
+	else if (match_keyword(KW_IF) ||
+			 match_keyword(KW_ELIF) ||
+			 match_keyword(KW_ELSE)) {
 		error_loc = IF_HEADER;
 		goto_previous_token();
-		if (str_intern(current()->lexeme) ==
-			str_intern("if")) {
+		if (current()->keyword == KW_IF) {
 			error("if statement requires function scope; ");
 			RECOVER;
 			return null;
@@ -502,7 +503,7 @@ Stmt* Parser::decl(bool is_global) {
 		}
 	}
 
-	else if (match_keyword("for")) {
+	else if (match_keyword(KW_FOR)) {
 		error_loc = FOR_HEADER;
 		goto_previous_token();
 		error("for statement requires function scope;");
@@ -510,7 +511,7 @@ Stmt* Parser::decl(bool is_global) {
 		return null;
 	}
 
-	else if (match_keyword("switch")) {
+	else if (match_keyword(KW_SWITCH)) {
 		error_loc = SWITCH_HEADER;
 		goto_previous_token();
 		error("for statement requires function scope;");
@@ -518,7 +519,7 @@ Stmt* Parser::decl(bool is_global) {
 		return null;
 	}
 
-	else if (match_keyword("return")) {
+	else if (match_keyword(KW_RETURN)) {
 		error_loc = GLOBAL;
 		goto_previous_token();
 		error("cannot return from global scope; ");
@@ -553,7 +554,10 @@ Stmt* Parser::stmt() {
 	
 	if (match_identifier()) {
 		Token* identifier = previous();
-		DataType* data_type = match_data_type();
+		DataType* data_type = null;
+		if (current()->type != T_LBRACKET || brackets_start_data_type()) {
+			data_type = match_data_type();
+		}
 		Expr* initializer = null;
 		if (!data_type) {
 			if (!match_double_colon()) {
@@ -586,7 +590,7 @@ Stmt* Parser::stmt() {
 		}
 	}
 	
-	else if (match_keyword("if")) {
+	else if (match_keyword(KW_IF)) {
 		STMT_CREATE(stmt);
 		stmt->type = S_IF;
 		stmt->if_stmt.elif_branch = null;
@@ -596,13 +600,13 @@ Stmt* Parser::stmt() {
 			RECOVER;
 		}
 
-		while (match_keyword("elif")) {
+		while (match_keyword(KW_ELIF)) {
 			if_branch(stmt, IF_ELIF_BRANCH);
 			CHECK_EOF(null);			
 			RECOVER;
 		}
 
-		if (match_keyword("else")) {
+		if (match_keyword(KW_ELSE)) {
 			if_branch(stmt, IF_ELSE_BRANCH);
 			RECOVER;
 		}
@@ -610,7 +614,7 @@ Stmt* Parser::stmt() {
 		return stmt;
 	}
 
-	else if (match_keyword("for")) {
+	else if (match_keyword(KW_FOR)) {
 		error_loc = FOR_HEADER;
 		STMT_CREATE(counter);
 		counter->type = S_VAR_DECL;
@@ -649,7 +653,7 @@ Stmt* Parser::stmt() {
 							   body);
 	}
 
-	else if (match_keyword("switch")) {
+	else if (match_keyword(KW_SWITCH)) {
 		STMT_CREATE(stmt);
 		stmt->type = S_SWITCH;
 		error_loc = SWITCH_HEADER;
@@ -675,7 +679,7 @@ Stmt* Parser::stmt() {
 		return stmt;
 	}
 
-	else if (match_keyword("return")) {
+	else if (match_keyword(KW_RETURN)) {
 		Expr* to_return = null;
 		if (!match_semicolon()) {
 			EXPR_ND(to_return);
@@ -685,8 +689,8 @@ Stmt* Parser::stmt() {
 		return return_stmt_create(to_return);
 	}
 	
-	else if (match_keyword("elif") ||
-			 match_keyword("else")) {
+	else if (match_keyword(KW_ELIF) ||
+			 match_keyword(KW_ELSE)) {
 		error_loc = IF_HEADER;
 		goto_previous_token();
 		error("%s without preceding if statement;", current()->lexeme);
@@ -729,7 +733,7 @@ Stmt* Parser::if_branch(Stmt* if_stmt, IfBranchType type) {
 		CHECK_EOF(null);		
 	}
 
-	IfBranch* branch = new IfBranch();
+	IfBranch* branch = AST_NEW(ast_arena, AST_IF_BRANCH, IfBranch);
 	branch->cond = cond;
 	branch->body = body;
 	
@@ -767,7 +771,7 @@ Stmt* Parser::switch_branch(Stmt* switch_stmt) {
 	Stmt* s = stmt();
 	EXIT_ERROR null;
 
-	SwitchBranch* switch_branch = new SwitchBranch;
+	SwitchBranch* switch_branch = AST_NEW(ast_arena, AST_SWITCH_BRANCH, SwitchBranch);
 	switch_branch->conds = conds;
 	switch_branch->stmt = s;
 
@@ -797,7 +801,7 @@ Stmt* Parser::struct_create(Stmt* stmt, Token* identifier, Stmt** fields) {
 
 Stmt* Parser::func_decl_create(Token* identifier, Stmt** params, DataType* return_data_type, Stmt** body, bool is_function, bool is_public) {
 	if (return_data_type == null) {
-		return_data_type = data_type_from_string("void");
+		return_data_type = data_type_from_string(ast_arena, "void");
 	}
 	
 	STMT_CREATE(stmt);
@@ -813,7 +817,7 @@ Stmt* Parser::func_decl_create(Token* identifier, Stmt** params, DataType* retur
 	// if extern functions are not to be seen by other
 	// files, add condition here
 	if (is_public) {
-		if (!current_struct && str_intern(identifier->lexeme) == str_intern("main")) {
+		if (!current_struct && identifier->lexeme == names.main) {
 		}
 		else {
 			STMT_CREATE(decl);
@@ -848,6 +852,7 @@ Stmt* Parser::global_var_decl_create(Token* identifier, DataType* data_type, Exp
 	decl->var_decl.initializer = null;
 	decl->var_decl.is_variable = false;
 	buf_push(decls, decl);
+	stmt->var_decl.decl = decl;
 	
 	return stmt;
 }
@@ -1089,9 +1094,9 @@ Expr* Parser::expr_precedence_0() {
 	else if (match_by_type(T_CHAR)) {
 		return char_create(previous());
 	}
-	else if (match_keyword("true") ||
-			 match_keyword("false") ||
-			 match_keyword("null")) {
+	else if (match_keyword(KW_TRUE) ||
+			 match_keyword(KW_FALSE) ||
+			 match_keyword(KW_NULL)) {
 		return constant_create(previous());
 	}
 	else if (current()->type == T_LPAREN) {
@@ -1111,7 +1116,7 @@ Expr* Parser::expr_grouping() {
 	return e;
 }
 
-#define EXPR_CREATE(name) Expr* name = new Expr();
+#define EXPR_CREATE(name) Expr* name = AST_NEW(ast_arena, AST_EXPR, Expr);
 
 Expr* Parser::binary_create(Expr* left, Expr* right, Token* op) {
 	EXPR_CREATE(expr);
@@ -1231,10 +1236,8 @@ bool Parser::match_identifier() {
 	return false;
 }
 
-bool Parser::match_keyword(char* keyword) {
-	if (current()->type == T_KEYWORD &&
-		(str_intern(current()->lexeme) ==
-		 str_intern(keyword))) {
+bool Parser::match_keyword(KeywordType keyword) {
+	if (current()->keyword == keyword) {
 		goto_next_token();
 		return true;
 	}
@@ -1319,6 +1322,37 @@ bool Parser::match_semicolon() {
 	return false;
 }
 
+/* in a function body, ‘name [’ starts either an array declaration,
+ * "a [4]int", or an indexing expression, "a[i] = 2". it is a
+ * declaration when a type name follows the matching ‘]’; a statement
+ * that ends first is left to the declaration to report */
+bool Parser::brackets_start_data_type() {
+	u64 depth = 0;
+	for (u64 idx = token_idx; idx < tokens_len; idx++) {
+		switch (tokens[idx].type) {
+		case T_LBRACKET:
+			depth++;
+			break;
+		case T_RBRACKET:
+			depth--;
+			if (depth == 0) {
+				return (idx + 1 < tokens_len &&
+						(tokens[idx + 1].type == T_IDENTIFIER ||
+						 tokens[idx + 1].type == T_CARET));
+			}
+			break;
+		case T_SEMICOLON:
+		case T_LBRACE:
+		case T_RBRACE:
+		case T_EOF:
+			return true;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
 DataType* Parser::match_data_type() {
 	bool is_array = false;
 	bool array_matched = false;
@@ -1380,7 +1414,8 @@ DataType* Parser::match_data_type() {
 	if (!start) {
 		start = previous();
 	}	
-	return data_type_create(identifier,
+	return data_type_create(ast_arena,
+							identifier,
 							pointer_count,
 							is_array,
 							array_elem_count,
@@ -1476,14 +1511,14 @@ Token* Parser::current() {
 	if (token_idx >= tokens_len) {
 		return null;
 	}
-	return tokens[token_idx];
+	return &tokens[token_idx];
 }
 
 Token* Parser::previous() {
 	if (token_idx >= tokens_len+1) {
 		return null;
 	}
-	return tokens[token_idx-1];
+	return &tokens[token_idx-1];
 }
 
 void Parser::goto_next_token() {
@@ -1499,7 +1534,7 @@ void Parser::goto_previous_token() {
 	}
 }
 
-void Parser::error_root(SourceFile* _srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap) {
+void Parser::error_root(SourceFile* _srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
 	if (error_panic) {
 		error_count++;		
 		sync_to_next_statement();
@@ -1509,8 +1544,7 @@ void Parser::error_root(SourceFile* _srcfile, u64 line, u64 column, u64 char_cou
 	
 	print_error_at(
 		_srcfile,
-		line,
-		column,
+		offset,
 		char_count,
 		fmt,
 		ap);
@@ -1520,11 +1554,10 @@ void Parser::error_root(SourceFile* _srcfile, u64 line, u64 column, u64 char_cou
 	error_count++;		
 }
 
-void Parser::warning_root(SourceFile* _srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap) {
+void Parser::warning_root(SourceFile* _srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
 	print_warning_at(
 		_srcfile,
-		line,
-		column,
+		offset,
 		char_count,
 		fmt,
 		ap);
@@ -1535,8 +1568,7 @@ void Parser::verror(const char* fmt, va_list ap) {
 	va_copy(aq, ap);
 	error_root(
 		srcfile,
-		current()->line,
-		current()->column,
+		current()->offset,
 		current()->char_count,
 		fmt,
 		aq);
@@ -1592,14 +1624,3 @@ void Parser::sync_to_next_statement() {
 	}
 	goto_next_token();
 }
-
-void Parser::add_pending_imports() {
-	buf_loop(pending_imports, i) {
-		Compiler compiler;
-		Stmt** target_decls = compiler.compile(pending_imports[i]);
-		
-		buf_loop(target_decls, d) {
-			buf_push(stmts, target_decls[d]);	
-		}
-	}
-}
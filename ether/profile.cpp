@@ -0,0 +1,689 @@
+#include <ether.hpp>
+#include <profile.hpp>
+#include <stmt.hpp>
+#include <data_type.hpp>
+#include <stats.hpp>
+#include <math.hpp>
+
+#include <fcntl.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define NS_PER_MS 1000000.0
+
+ProfileFlags profile_flags;
+
+static const char* phase_names[_PHASE_COUNT] = {
+	"read",
+	"lex",
+	"parse",
+	"imports",
+	"link",
+	"resolve",
+	"fold",
+	"ir",
+	"code gen",
+	"cc / nasm",
+};
+
+static const char* memory_subsystem_names[_MEM_SUBSYSTEM_COUNT] = {
+	"tokens",
+	"ast nodes",
+	"interned strings",
+	"types",
+	"type strings",
+	"linker scopes",
+	"buf growth",
+};
+
+static const char* perf_counter_names[_PERF_COUNTER_COUNT] = {
+	"cycles",
+	"instructions",
+	"cache-misses",
+	"branch-misses",
+	"page-faults",
+};
+
+static const u32 perf_counter_types[_PERF_COUNTER_COUNT] = {
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_SOFTWARE,
+};
+
+static const u64 perf_counter_configs[_PERF_COUNTER_COUNT] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES,
+	PERF_COUNT_SW_PAGE_FAULTS,
+};
+
+/* the counters of one thread, read together as one group. a counter
+ * the kernel or the cpu refuses is left out of the group */
+struct PerfThread {
+	bool opened;
+	int group_fd;
+	int fds[_PERF_COUNTER_COUNT];
+	u64 count;
+
+	~PerfThread() {
+		for (u64 c = 0; c < _PERF_COUNTER_COUNT; c++) {
+			if (fds[c] != -1) close(fds[c]);
+		}
+	}
+};
+
+/* a span of work on one thread: a phase, when stmt is null and phase
+ * is not _PHASE_COUNT; a whole file, when it is; or a top-level
+ * declaration going through phase */
+struct TraceEvent {
+	ProfilePhase phase;
+	FileProfile* file;
+	Stmt* stmt;
+	u64 start_ns;
+	u64 dur_ns;
+};
+
+/* the events of one worker index. compile_units_parallel starts new
+ * threads every wave, but the threads of one index never run at once,
+ * so events are appended without locking, and read once every thread
+ * is done */
+struct TraceThread {
+	u64 tid;
+	TraceEvent* events;
+};
+
+/* true if any profile was asked for; the one check a disabled
+ * profile_begin and profile_end make */
+static bool profile_active = false;
+static bool trace_active = false;
+static bool perf_active = false;
+static bool mem_active = false;
+static u64 memory_bytes[_MEM_SUBSYSTEM_COUNT];
+/* which counters the first thread could open; every thread opens the same */
+static bool perf_available[_PERF_COUNTER_COUNT];
+static ProfileMark run_start;
+/* phases that belong to no file */
+static PhaseTime run_phases[_PHASE_COUNT];
+static FileProfile** files = null;
+static TraceThread** trace_threads = null;
+static thread_local TraceThread* trace_thread = null;
+static thread_local PerfThread perf_thread;
+static std::mutex files_mutex;
+
+static u64 clock_ns(clockid_t clock) {
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return (u64)ts.tv_sec * 1000000000 + (u64)ts.tv_nsec;
+}
+
+/* cpu time of the cc and nasm runs that have ended */
+static u64 children_cpu_ns() {
+	struct rusage usage;
+	getrusage(RUSAGE_CHILDREN, &usage);
+	return ((u64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000 +
+			(u64)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000);
+}
+
+static int perf_event_open(struct perf_event_attr* attr, int group_fd) {
+	return (int)syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0);
+}
+
+/* counts user space of the calling thread only, which is what an
+ * unprivileged process may count under the default perf_event_paranoid */
+static void perf_thread_open(PerfThread* thread) {
+	thread->opened = true;
+	thread->group_fd = -1;
+	thread->count = 0;
+	for (u64 c = 0; c < _PERF_COUNTER_COUNT; c++) {
+		thread->fds[c] = -1;
+		if (!perf_available[c]) continue;
+
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = perf_counter_types[c];
+		attr.config = perf_counter_configs[c];
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = (PERF_FORMAT_GROUP |
+							PERF_FORMAT_TOTAL_TIME_ENABLED |
+							PERF_FORMAT_TOTAL_TIME_RUNNING);
+		int fd = perf_event_open(&attr, thread->group_fd);
+		if (fd == -1) continue;
+
+		thread->fds[c] = fd;
+		thread->count++;
+		if (thread->group_fd == -1) {
+			thread->group_fd = fd;
+		}
+	}
+}
+
+/* the counters of the calling thread so far, scaled up when the
+ * kernel had to share the hardware with other counters */
+static void perf_read(u64* counters) {
+	if (!perf_thread.opened) {
+		perf_thread_open(&perf_thread);
+	}
+	memset(counters, 0, _PERF_COUNTER_COUNT * sizeof(u64));
+	if (perf_thread.group_fd == -1) {
+		return;
+	}
+
+	u64 values[3 + _PERF_COUNTER_COUNT];
+	if (read(perf_thread.group_fd, values, sizeof(values)) < (ssize_t)(3 * sizeof(u64))) {
+		return;
+	}
+	u64 enabled = values[1];
+	u64 running = values[2];
+	u64 v = 3;
+	for (u64 c = 0; c < _PERF_COUNTER_COUNT; c++) {
+		if (perf_thread.fds[c] == -1) continue;
+		counters[c] = (running && running < enabled ?
+					   (u64)((double)values[v] * enabled / running) :
+					   values[v]);
+		v++;
+	}
+}
+
+/* finds out on the main thread which counters can be had at all, and
+ * says once if none can */
+static void perf_init() {
+	for (u64 c = 0; c < _PERF_COUNTER_COUNT; c++) {
+		perf_available[c] = true;
+	}
+	perf_thread_open(&perf_thread);
+	if (perf_thread.count == 0) {
+		ether_print_error("warning: cannot open performance counters: %s; "
+						  "--perf-counters is ignored;",
+						  strerror(errno));
+		perf_active = false;
+		return;
+	}
+	for (u64 c = 0; c < _PERF_COUNTER_COUNT; c++) {
+		perf_available[c] = (perf_thread.fds[c] != -1);
+	}
+}
+
+/* resident set of the whole process now, from /proc/self/statm */
+static u64 current_rss() {
+	int fd = open("/proc/self/statm", O_RDONLY);
+	if (fd == -1) {
+		return 0;
+	}
+	char buf[128];
+	ssize_t len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (len <= 0) {
+		return 0;
+	}
+	buf[len] = '\0';
+
+	u64 size_pages, resident_pages;
+	if (sscanf(buf, "%lu %lu", &size_pages, &resident_pages) != 2) {
+		return 0;
+	}
+	return resident_pages * (u64)sysconf(_SC_PAGESIZE);
+}
+
+static u64 peak_rss() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (u64)usage.ru_maxrss * 1024;
+}
+
+/* cpu time is the calling thread's, since files compile in parallel.
+ * a phase that runs cc or nasm waits on it, which takes no cpu of its
+ * own; the total counts theirs */
+static ProfileMark profile_now() {
+	ProfileMark mark;
+	mark.wall_ns = clock_ns(CLOCK_MONOTONIC);
+	mark.cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+	if (perf_active) {
+		perf_read(mark.counters);
+	}
+	if (mem_active) {
+		mark.rss = current_rss();
+	}
+	return mark;
+}
+
+void profile_init() {
+	trace_active = (profile_flags.trace_fpath != null);
+	perf_active = profile_flags.perf_counters;
+	if (perf_active) {
+		perf_init();
+	}
+	mem_active = profile_flags.mem_report;
+	profile_active = (profile_flags.time_report || trace_active || perf_active || mem_active);
+	if (profile_active) {
+		run_start = profile_now();
+		run_start.cpu_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID) + children_cpu_ns();
+	}
+}
+
+FileProfile* profile_file(char* fpath) {
+	if (!profile_active) {
+		return null;
+	}
+
+	FileProfile* file = new FileProfile();
+	file->fpath = fpath;
+	std::lock_guard<std::mutex> lock(files_mutex);
+	buf_push(files, file);
+	return file;
+}
+
+ProfileMark profile_begin() {
+	if (!profile_active) {
+		return {};
+	}
+	return profile_now();
+}
+
+/* traces the calling thread as worker index worker, which is its tid */
+void profile_thread(u64 worker) {
+	if (!trace_active) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(files_mutex);
+	while (buf_len(trace_threads) <= worker) {
+		TraceThread* thread = new TraceThread();
+		thread->tid = buf_len(trace_threads);
+		buf_push(trace_threads, thread);
+	}
+	trace_thread = trace_threads[worker];
+}
+
+static void trace_event(ProfilePhase phase, FileProfile* file, Stmt* stmt, u64 start_ns, u64 end_ns) {
+	/* only the main thread traces without being given an index */
+	if (!trace_thread) {
+		profile_thread(0);
+	}
+
+	TraceEvent event;
+	event.phase = phase;
+	event.file = file;
+	event.stmt = stmt;
+	event.start_ns = start_ns;
+	event.dur_ns = end_ns - start_ns;
+	buf_push(trace_thread->events, event);
+}
+
+void profile_end(ProfileMark mark, ProfilePhase phase, FileProfile* file) {
+	if (!profile_active) {
+		return;
+	}
+
+	ProfileMark now = profile_now();
+	PhaseTime* time = (file ? &file->phases[phase] : &run_phases[phase]);
+	time->wall_ns += now.wall_ns - mark.wall_ns;
+	time->cpu_ns += now.cpu_ns - mark.cpu_ns;
+	for (u64 c = 0; c < _PERF_COUNTER_COUNT; c++) {
+		/* scaled counts of a multiplexed group may step back a little */
+		if (now.counters[c] > mark.counters[c]) {
+			time->counters[c] += now.counters[c] - mark.counters[c];
+		}
+	}
+	if (mem_active) {
+		/* threads share the resident set, so with -j a phase also
+		 * gets what other threads grew it by meanwhile */
+		if (now.rss > mark.rss) {
+			time->rss_grown += now.rss - mark.rss;
+		}
+		time->peak_rss = MAX(time->peak_rss, peak_rss());
+	}
+	if (trace_active) {
+		trace_event(phase, file, null, mark.wall_ns, now.wall_ns);
+	}
+}
+
+void profile_memory(MemorySubsystem subsystem, u64 bytes) {
+	if (!mem_active) {
+		return;
+	}
+	__atomic_add_fetch(&memory_bytes[subsystem], bytes, __ATOMIC_RELAXED);
+}
+
+void profile_file_end(ProfileMark mark, FileProfile* file) {
+	if (!trace_active) {
+		return;
+	}
+	trace_event(_PHASE_COUNT, file, null, mark.wall_ns, clock_ns(CLOCK_MONOTONIC));
+}
+
+ProfileMark profile_stmt_begin() {
+	if (!trace_active) {
+		return {};
+	}
+	ProfileMark mark = {};
+	mark.wall_ns = clock_ns(CLOCK_MONOTONIC);
+	return mark;
+}
+
+/* declarations imported from other units are only declared here, so
+ * they are left out */
+void profile_stmt_end(ProfileMark mark, ProfilePhase phase, Stmt* stmt) {
+	if (!trace_active) {
+		return;
+	}
+	if ((stmt->type == S_FUNC_DECL && !stmt->func_decl.is_function) ||
+		(stmt->type == S_VAR_DECL && !stmt->var_decl.is_variable)) {
+		return;
+	}
+	trace_event(phase, null, stmt, mark.wall_ns, clock_ns(CLOCK_MONOTONIC));
+}
+
+struct ReportRow {
+	const char* name;
+	PhaseTime time;
+};
+
+/* slowest first */
+static int compare_rows(const void* a, const void* b) {
+	u64 wall_a = ((ReportRow*)a)->time.wall_ns;
+	u64 wall_b = ((ReportRow*)b)->time.wall_ns;
+	return (wall_a < wall_b) - (wall_a > wall_b);
+}
+
+static void print_row(const char* name, PhaseTime time, u64 run_wall_ns) {
+	fprintf(stderr, "  %10.3f  %10.3f  %6.1f%%  %s\n",
+			time.wall_ns / NS_PER_MS,
+			time.cpu_ns / NS_PER_MS,
+			100.0 * time.wall_ns / CLAMP_MIN(run_wall_ns, 1),
+			name);
+}
+
+/* every phase over all files, in pipeline order */
+static void sum_phases(ReportRow* phases) {
+	for (u64 p = 0; p < _PHASE_COUNT; p++) {
+		phases[p].name = phase_names[p];
+		phases[p].time = run_phases[p];
+		buf_loop(files, f) {
+			PhaseTime* time = &files[f]->phases[p];
+			phases[p].time.wall_ns += time->wall_ns;
+			phases[p].time.cpu_ns += time->cpu_ns;
+			for (u64 c = 0; c < _PERF_COUNTER_COUNT; c++) {
+				phases[p].time.counters[c] += time->counters[c];
+			}
+			phases[p].time.rss_grown += time->rss_grown;
+			phases[p].time.peak_rss = MAX(phases[p].time.peak_rss, time->peak_rss);
+		}
+	}
+}
+
+/* phases add up the time of every thread, so with -j they can take
+ * more than the run did */
+static void print_time_report() {
+	PhaseTime run;
+	run.wall_ns = clock_ns(CLOCK_MONOTONIC) - run_start.wall_ns;
+	run.cpu_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID) + children_cpu_ns() - run_start.cpu_ns;
+
+	ReportRow phases[_PHASE_COUNT];
+	sum_phases(phases);
+	qsort(phases, _PHASE_COUNT, sizeof(ReportRow), compare_rows);
+
+	ReportRow* file_rows = null;
+	buf_loop(files, f) {
+		ReportRow row = { files[f]->fpath, {} };
+		for (u64 p = 0; p < _PHASE_COUNT; p++) {
+			row.time.wall_ns += files[f]->phases[p].wall_ns;
+			row.time.cpu_ns += files[f]->phases[p].cpu_ns;
+		}
+		buf_push(file_rows, row);
+	}
+	if (file_rows) {
+		qsort(file_rows, buf_len(file_rows), sizeof(ReportRow), compare_rows);
+	}
+
+	std::lock_guard<std::mutex> lock(output_mutex);
+	fprintf(stderr, "\ntime report\n");
+	fprintf(stderr, "  %10s  %10s  %7s  %s\n", "wall ms", "cpu ms", "wall", "phase");
+	for (u64 p = 0; p < _PHASE_COUNT; p++) {
+		print_row(phases[p].name, phases[p].time, run.wall_ns);
+	}
+	print_row("total", run, run.wall_ns);
+
+	fprintf(stderr, "\n  %10s  %10s  %7s  %s\n", "wall ms", "cpu ms", "wall", "file");
+	buf_loop(file_rows, f) {
+		print_row(file_rows[f].name, file_rows[f].time, run.wall_ns);
+	}
+	buf_free(file_rows);
+}
+
+static void print_per_kilo(u64 count, u64 instructions, bool available) {
+	if (available && instructions) {
+		fprintf(stderr, "  %11.2f", 1000.0 * count / instructions);
+	}
+	else {
+		fprintf(stderr, "  %11s", "-");
+	}
+}
+
+static void print_perf_row(const char* name, u64* counters) {
+	fprintf(stderr, "  %14lu  %14lu", counters[PERF_CYCLES], counters[PERF_INSTRUCTIONS]);
+	if (perf_available[PERF_CYCLES] && perf_available[PERF_INSTRUCTIONS] && counters[PERF_CYCLES]) {
+		fprintf(stderr, "  %5.2f", (double)counters[PERF_INSTRUCTIONS] / counters[PERF_CYCLES]);
+	}
+	else {
+		fprintf(stderr, "  %5s", "-");
+	}
+	print_per_kilo(counters[PERF_CACHE_MISSES], counters[PERF_INSTRUCTIONS],
+				   perf_available[PERF_CACHE_MISSES] && perf_available[PERF_INSTRUCTIONS]);
+	print_per_kilo(counters[PERF_BRANCH_MISSES], counters[PERF_INSTRUCTIONS],
+				   perf_available[PERF_BRANCH_MISSES] && perf_available[PERF_INSTRUCTIONS]);
+	fprintf(stderr, "  %10lu  %s\n", counters[PERF_PAGE_FAULTS], name);
+}
+
+/* user-space counts of the compiler's own threads; cc and nasm are
+ * other processes, so the backend phase only shows the wait for them.
+ * misses are per thousand instructions, a counter the cpu does not
+ * have shows as 0 and its ratios as - */
+static void print_perf_report() {
+	ReportRow phases[_PHASE_COUNT];
+	sum_phases(phases);
+	u64 total[_PERF_COUNTER_COUNT] = {};
+	for (u64 p = 0; p < _PHASE_COUNT; p++) {
+		for (u64 c = 0; c < _PERF_COUNTER_COUNT; c++) {
+			total[c] += phases[p].time.counters[c];
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(output_mutex);
+	fprintf(stderr, "\nperf counters (unavailable:");
+	bool any_missing = false;
+	for (u64 c = 0; c < _PERF_COUNTER_COUNT; c++) {
+		if (!perf_available[c]) {
+			fprintf(stderr, " %s", perf_counter_names[c]);
+			any_missing = true;
+		}
+	}
+	fprintf(stderr, "%s)\n", (any_missing ? "" : " none"));
+	fprintf(stderr, "  %14s  %14s  %5s  %11s  %11s  %10s  %s\n",
+			"cycles", "instructions", "ipc", "cache mpki", "branch mpki", "faults", "phase");
+	for (u64 p = 0; p < _PHASE_COUNT; p++) {
+		print_perf_row(phases[p].name, phases[p].time.counters);
+	}
+	print_perf_row("total", total);
+}
+
+#define BYTES_PER_MB (1024.0 * 1024.0)
+
+/* bytes each subsystem holds, or for linker scopes and buf growth
+ * has allocated, since nothing frees before the end of the run. buf
+ * growth counts every buf, so it overlaps tokens and scopes. a phase
+ * that never ran shows as -, as in the perf report */
+static void print_mem_report() {
+	u64 canonical_bytes, string_bytes;
+	data_type_memory(&canonical_bytes, &string_bytes);
+	u64 intern_count, intern_bytes, intern_blocks;
+	str_intern_stats(&intern_count, &intern_bytes, &intern_blocks);
+	memory_bytes[MEM_INTERN] = intern_bytes + str_intern_table_bytes();
+	memory_bytes[MEM_TYPES] = canonical_bytes;
+	memory_bytes[MEM_TYPE_STRINGS] = string_bytes;
+	memory_bytes[MEM_BUFS] = stats_total(STAT_BUF_BYTES_GROWN);
+
+	ReportRow phases[_PHASE_COUNT];
+	sum_phases(phases);
+
+	std::lock_guard<std::mutex> lock(output_mutex);
+	fprintf(stderr, "\nmemory report\n");
+	fprintf(stderr, "  %14s  %10s  %s\n", "bytes", "MB", "subsystem");
+	for (u64 m = 0; m < _MEM_SUBSYSTEM_COUNT; m++) {
+		fprintf(stderr, "  %14lu  %10.3f  %s\n",
+				memory_bytes[m],
+				memory_bytes[m] / BYTES_PER_MB,
+				memory_subsystem_names[m]);
+	}
+
+	fprintf(stderr, "\n  %12s  %12s  %s\n", "rss grown MB", "peak rss MB", "phase");
+	for (u64 p = 0; p < _PHASE_COUNT; p++) {
+		/* every sample sets peak_rss, so a phase that never ran has none */
+		if (!phases[p].time.peak_rss) {
+			fprintf(stderr, "  %12s  %12s  %s\n", "-", "-", phases[p].name);
+			continue;
+		}
+		fprintf(stderr, "  %12.3f  %12.3f  %s\n",
+				phases[p].time.rss_grown / BYTES_PER_MB,
+				phases[p].time.peak_rss / BYTES_PER_MB,
+				phases[p].name);
+	}
+	fprintf(stderr, "  %12s  %12.3f  %s\n", "", peak_rss() / BYTES_PER_MB, "total");
+}
+
+static void write_json_string(Writer* writer, const char* str) {
+	writer_write_char(writer, '"');
+	for (; *str; str++) {
+		char ch = *str;
+		if (ch == '"' || ch == '\\') {
+			writer_write_char(writer, '\\');
+			writer_write_char(writer, ch);
+		}
+		else if ((u8)ch < ' ') {
+			char escape[8];
+			snprintf(escape, sizeof(escape), "\\u%04x", ch);
+			writer_write_str(writer, escape);
+		}
+		else {
+			writer_write_char(writer, ch);
+		}
+	}
+	writer_write_char(writer, '"');
+}
+
+/* a struct function is named after its struct too */
+static void write_stmt_name(Writer* writer, Stmt* stmt) {
+	char name[256];
+	switch (stmt->type) {
+	case S_STRUCT:
+		snprintf(name, sizeof(name), "%s", stmt->struct_stmt.identifier->lexeme);
+		break;
+	case S_FUNC_DECL:
+		if (stmt->func_decl.struct_in) {
+			snprintf(name, sizeof(name), "%s.%s",
+					 stmt->func_decl.struct_in->struct_stmt.identifier->lexeme,
+					 stmt->func_decl.identifier->lexeme);
+		}
+		else {
+			snprintf(name, sizeof(name), "%s", stmt->func_decl.identifier->lexeme);
+		}
+		break;
+	case S_VAR_DECL:
+		snprintf(name, sizeof(name), "%s", stmt->var_decl.identifier->lexeme);
+		break;
+	default:
+		snprintf(name, sizeof(name), "?");
+		break;
+	}
+	write_json_string(writer, name);
+}
+
+/* complete ("X") events in microseconds from the start of the run, in
+ * the JSON object format that chrome://tracing and Perfetto load */
+static void write_trace() {
+	Writer writer;
+	if (writer_open(&writer, profile_flags.trace_fpath) == ETHER_ERROR) {
+		return;
+	}
+
+	char num[64];
+	bool first = true;
+	writer_write_str(&writer, "{\"traceEvents\":[\n");
+	buf_loop(trace_threads, t) {
+		TraceThread* thread = trace_threads[t];
+		buf_loop(thread->events, e) {
+			TraceEvent* event = &thread->events[e];
+			writer_write_str(&writer, (first ? "{\"name\":" : ",\n{\"name\":"));
+			first = false;
+
+			const char* category;
+			if (event->stmt) {
+				write_stmt_name(&writer, event->stmt);
+				category = phase_names[event->phase];
+			}
+			else if (event->phase == _PHASE_COUNT) {
+				write_json_string(&writer, event->file->fpath);
+				category = "file";
+			}
+			else {
+				write_json_string(&writer, phase_names[event->phase]);
+				category = "phase";
+			}
+			writer_write_str(&writer, ",\"cat\":");
+			write_json_string(&writer, category);
+
+			snprintf(num, sizeof(num), ",\"ph\":\"X\",\"pid\":1,\"tid\":%lu", thread->tid);
+			writer_write_str(&writer, num);
+			snprintf(num, sizeof(num), ",\"ts\":%.3f,\"dur\":%.3f",
+					 (event->start_ns - run_start.wall_ns) / 1000.0,
+					 event->dur_ns / 1000.0);
+			writer_write_str(&writer, num);
+			if (event->phase != _PHASE_COUNT && !event->stmt && event->file) {
+				writer_write_str(&writer, ",\"args\":{\"file\":");
+				write_json_string(&writer, event->file->fpath);
+				writer_write_char(&writer, '}');
+			}
+			writer_write_char(&writer, '}');
+		}
+	}
+	writer_write_str(&writer, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	writer_commit(&writer);
+}
+
+/* reports what was asked for; the AST must still be alive, since
+ * trace events name declarations by their Stmt */
+void profile_finish() {
+	if (!profile_active) {
+		return;
+	}
+
+	if (profile_flags.time_report) {
+		print_time_report();
+	}
+	if (perf_active) {
+		print_perf_report();
+	}
+	if (mem_active) {
+		print_mem_report();
+	}
+	if (trace_active) {
+		write_trace();
+	}
+
+	buf_loop(trace_threads, t) {
+		buf_free(trace_threads[t]->events);
+		delete trace_threads[t];
+	}
+	buf_free(trace_threads);
+	buf_loop(files, f) {
+		delete files[f];
+	}
+	buf_free(files);
+}
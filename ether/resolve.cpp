@@ -4,6 +4,8 @@
 #include <expr.hpp>
 #include <data_type.hpp>
 #include <token.hpp>
+#include <linker.hpp>
+#include <profile.hpp>
 
 #define CURRENT_ERROR u64 current_error_count = error_count;
 #define EXIT_ERROR_VOID_RETURN if (error_count > current_error_count) return;
@@ -11,21 +13,78 @@
 
 error_code Resolve::resolve(Stmt** _stmts) {
 	stmts = _stmts;
+	structs = {};
 	error_count = 0;
-	data_type_strings = null;
 
+	add_structs();
+
+	/* globals first, so functions see the types inferred for them */
 	buf_loop(stmts, s) {
-		resolve_stmt(stmts[s]);
+		if (stmts[s]->type == S_VAR_DECL) {
+			ProfileMark mark = profile_stmt_begin();
+			resolve_var_decl(stmts[s]);
+			profile_stmt_end(mark, PHASE_RESOLVE, stmts[s]);
+		}
 	}
-	
-	destroy();
+	buf_loop(stmts, s) {
+		if (stmts[s]->type != S_VAR_DECL) {
+			ProfileMark mark = profile_stmt_begin();
+			resolve_stmt(stmts[s]);
+			profile_stmt_end(mark, PHASE_RESOLVE, stmts[s]);
+		}
+	}
+
+	free_structs();
+	return (error_count == 0 ?
+			ETHER_SUCCESS :
+			ETHER_ERROR);
 }
 
-void Resolve::destroy() {
-	buf_loop(data_type_strings, i) {
-		free(data_type_strings[i]);
+/* the linker has checked every name, so this only indexes structs
+ * and their functions, imported ones included, for member lookup */
+void Resolve::add_structs() {
+	buf_loop(stmts, s) {
+		if (stmts[s]->type == S_STRUCT &&
+			!map_get(&structs, stmts[s]->struct_stmt.identifier->lexeme)) {
+			StructFunctionMap* map = new StructFunctionMap;
+			map->stmt = stmts[s];
+			map->functions = null;
+			map->function_map = {};
+			map_put(&structs, stmts[s]->struct_stmt.identifier->lexeme, map);
+		}
 	}
-	buf_free(data_type_strings);
+
+	buf_loop(stmts, s) {
+		Stmt* stmt = stmts[s];
+		if (stmt->type == S_FUNC_DECL && stmt->func_decl.struct_in) {
+			StructFunctionMap* map =
+				(StructFunctionMap*)map_get(&structs,
+											stmt->func_decl.struct_in->struct_stmt.identifier->lexeme);
+			if (map && !map_get(&map->function_map, stmt->func_decl.identifier->lexeme)) {
+				map_put(&map->function_map, stmt->func_decl.identifier->lexeme, stmt);
+			}
+		}
+	}
+}
+
+void Resolve::free_structs() {
+	for (u64 i = 0; i < structs.cap; i++) {
+		if (structs.keys[i]) {
+			StructFunctionMap* map = (StructFunctionMap*)structs.vals[i];
+			map_free(&map->function_map);
+			delete map;
+		}
+	}
+	map_free(&structs);
+}
+
+/* the struct a value of this type has members of; a pointer to a
+ * struct has them too */
+StructFunctionMap* Resolve::struct_of(DataType* data_type) {
+	if (data_type->is_array || data_type->pointer_count > 1) {
+		return null;
+	}
+	return (StructFunctionMap*)map_get(&structs, data_type->identifier->lexeme);
 }
 
 void Resolve::resolve_stmt(Stmt* stmt) {
@@ -45,6 +104,12 @@ void Resolve::resolve_stmt(Stmt* stmt) {
 	case S_FOR:
 		resolve_for_stmt(stmt);
 		break;
+	case S_SWITCH:
+		resolve_switch_stmt(stmt);
+		break;
+	case S_RETURN:
+		resolve_return_stmt(stmt);
+		break;
 	case S_EXPR_STMT:
 		resolve_expr_stmt(stmt);
 		break;
@@ -85,6 +150,9 @@ void Resolve::resolve_var_decl(Stmt* stmt) {
 	}
 	else if (!stmt->var_decl.data_type) {
 		stmt->var_decl.data_type = resolve_expr(stmt->var_decl.initializer);
+		if (stmt->var_decl.decl) {
+			stmt->var_decl.decl->var_decl.data_type = stmt->var_decl.data_type;
+		}
 	}
 }
 
@@ -149,6 +217,66 @@ void Resolve::resolve_for_stmt(Stmt* stmt) {
 	}
 }
 
+void Resolve::resolve_switch_stmt(Stmt* stmt) {
+	u64 cond_error_count = error_count;
+	DataType* cond_type = resolve_expr(stmt->switch_stmt.cond);
+	bool cond_error = (error_count > cond_error_count);
+
+	buf_loop(stmt->switch_stmt.branches, b) {
+		SwitchBranch* branch = stmt->switch_stmt.branches[b];
+		buf_loop(branch->conds, c) {
+			CURRENT_ERROR;
+			DataType* branch_cond_type = resolve_expr(branch->conds[c]);
+			if (cond_error || error_count > current_error_count) {
+				continue;
+			}
+
+			DataTypeMatch match = data_type_match(branch_cond_type, cond_type);
+			if (match == DT_NOT_MATCH) {
+				error_expr(branch->conds[c],
+						   "expect ‘%s’ type;",
+						   data_type_to_string(cond_type));
+			}
+		}
+		resolve_stmt(branch->stmt);
+	}
+}
+
+void Resolve::resolve_return_stmt(Stmt* stmt) {
+	Stmt* function = stmt->return_stmt.function_refed;
+	DataType* return_type = function->func_decl.return_data_type;
+	bool returns_void = (data_type_match(return_type, data_types.t_void) == DT_MATCH);
+
+	if (!stmt->return_stmt.to_return) {
+		if (!returns_void) {
+			error_token(function->func_decl.identifier,
+						"function ‘%s’ returns ‘%s’, but a return has no value;",
+						function->func_decl.identifier->lexeme,
+						data_type_to_string(return_type));
+		}
+		return;
+	}
+
+	CURRENT_ERROR;
+	DataType* to_return_type = resolve_expr(stmt->return_stmt.to_return);
+	EXIT_ERROR_VOID_RETURN;
+
+	if (returns_void) {
+		error_expr(stmt->return_stmt.to_return,
+				   "function ‘%s’ returns ‘void’, cannot return a value;",
+				   function->func_decl.identifier->lexeme);
+		return;
+	}
+
+	DataTypeMatch match = data_type_match(to_return_type, return_type);
+	if (match == DT_NOT_MATCH) {
+		error_expr(stmt->return_stmt.to_return,
+				   "cannot implicitly convert from ‘%s’ to ‘%s’;",
+				   data_type_to_string(to_return_type),
+				   data_type_to_string(return_type));
+	}
+}
+
 void Resolve::resolve_expr_stmt(Stmt* stmt) {
 	resolve_expr(stmt->expr_stmt);	
 }
@@ -160,30 +288,44 @@ void Resolve::resolve_block(Stmt* stmt) {
 }
 
 DataType* Resolve::resolve_expr(Expr* expr) {
+	DataType* data_type = null;
 	switch (expr->type) {
 	case E_BINARY:
-		return resolve_binary_expr(expr);
+		data_type = resolve_binary_expr(expr);
+		break;
 	case E_UNARY:
-		return resolve_unary_expr(expr);
+		data_type = resolve_unary_expr(expr);
+		break;
 	case E_CAST:
-		return resolve_cast_expr(expr);
+		data_type = resolve_cast_expr(expr);
+		break;
 	case E_FUNC_CALL:
-		return resolve_func_call(expr);
+		data_type = resolve_func_call(expr);
+		break;
 	case E_ARRAY_ACCESS:
-		return resolve_array_access(expr);
+		data_type = resolve_array_access(expr);
+		break;
 	case E_MEMBER_ACCESS:
-		return resolve_member_access(expr);
+		data_type = resolve_member_access(expr);
+		break;
 	case E_VARIABLE_REF:
-		return resolve_variable_ref(expr);
+		data_type = resolve_variable_ref(expr);
+		break;
 	case E_NUMBER:
-		return resolve_number_expr(expr);
+		data_type = resolve_number_expr(expr);
+		break;
 	case E_STRING:
-		return data_types.t_string;
+		data_type = data_types.t_string;
+		break;
 	case E_CHAR:
-		return data_types.t_char;
+		data_type = data_types.t_char;
+		break;
 	case E_CONSTANT:
-		return resolve_constant_expr(expr);
+		data_type = resolve_constant_expr(expr);
+		break;
 	}
+	expr->data_type = data_type;
+	return data_type;
 }
 
 DataType* Resolve::resolve_binary_expr(Expr* expr) {
@@ -215,9 +357,37 @@ DataType* Resolve::resolve_binary_expr(Expr* expr) {
 	case T_GREATER_GREATER:
 		return resolve_bitshift_expr(expr);
 
+	case T_EQUAL:
+		return resolve_assign_expr(expr);
+
 	default:
+		assert(0);
 		break;
 	}
+	return null;
+}
+
+DataType* Resolve::resolve_assign_expr(Expr* expr) {
+	CURRENT_ERROR;
+	DataType* left_type = resolve_expr(expr->binary.left);
+	DataType* right_type = resolve_expr(expr->binary.right);
+	EXIT_ERROR(null);
+
+	if (left_type->is_array) {
+		error_expr(expr->binary.left,
+				   "cannot assign to an array;");
+		return null;
+	}
+
+	DataTypeMatch match = data_type_match(left_type, right_type);
+	if (match == DT_NOT_MATCH) {
+		error_expr(expr->binary.right,
+				   "cannot implicitly convert from ‘%s’ to ‘%s’;",
+				   data_type_to_string(right_type),
+				   data_type_to_string(left_type));
+		return null;
+	}
+	return left_type;
 }
 
 DataType* Resolve::resolve_arithmetic_expr(Expr* expr) {
@@ -277,6 +447,21 @@ DataType* Resolve::resolve_logic_binary_expr(Expr* expr) {
 }
 
 DataType* Resolve::resolve_bitwise_binary_expr(Expr* expr) {
+	CURRENT_ERROR;
+	DataType* left_type = resolve_expr(expr->binary.left);
+	DataType* right_type = resolve_expr(expr->binary.right);
+	EXIT_ERROR(null);
+
+	if (data_type_integer(left_type) == DT_NOT_MATCH ||
+		data_type_match(left_type, right_type) == DT_NOT_MATCH) {
+		error_token(expr->binary.op,
+					"operator ‘%s’ cannot operate on types ‘%s’ and ‘%s’;",
+					expr->binary.op->lexeme,
+					data_type_to_string(left_type),
+					data_type_to_string(right_type));
+		return null;
+	}
+	return left_type;
 }
 
 DataType* Resolve::resolve_comparison_expr(Expr* expr) {
@@ -299,9 +484,83 @@ DataType* Resolve::resolve_comparison_expr(Expr* expr) {
 }
 
 DataType* Resolve::resolve_bitshift_expr(Expr* expr) {
+	CURRENT_ERROR;
+	DataType* left_type = resolve_expr(expr->binary.left);
+	DataType* right_type = resolve_expr(expr->binary.right);
+	EXIT_ERROR(null);
+
+	/* the shift count can be of any integer type */
+	if (data_type_integer(left_type) == DT_NOT_MATCH ||
+		data_type_integer(right_type) == DT_NOT_MATCH) {
+		error_token(expr->binary.op,
+					"operator ‘%s’ cannot operate on types ‘%s’ and ‘%s’;",
+					expr->binary.op->lexeme,
+					data_type_to_string(left_type),
+					data_type_to_string(right_type));
+		return null;
+	}
+	return left_type;
 }
 
-DataType* Resolve::resolve_unary_expr(Expr* expr) {	
+DataType* Resolve::resolve_unary_expr(Expr* expr) {
+	CURRENT_ERROR;
+	DataType* right_type = resolve_expr(expr->unary.right);
+	EXIT_ERROR(null);
+
+	Token* op = expr->unary.op;
+	bool is_number = (data_type_integer(right_type) == DT_MATCH ||
+					  data_type_match(right_type, data_types.t_f32) == DT_MATCH ||
+					  data_type_match(right_type, data_types.t_f64) == DT_MATCH);
+	switch (op->type) {
+	case T_PLUS:
+	case T_MINUS:
+		if (is_number) return right_type;
+		break;
+		
+	case T_TILDE:
+		if (data_type_integer(right_type) == DT_MATCH) return right_type;
+		break;
+		
+	case T_BANG:
+		if (data_type_match(right_type, data_types.t_bool) == DT_MATCH) return right_type;
+		break;
+		
+	case T_CARET:
+		if (right_type->pointer_count != 0 && !right_type->is_array) {
+			DataType* deref_type = data_type_canonical(right_type->identifier->lexeme,
+													   right_type->pointer_count - 1,
+													   false,
+													   null);
+			if (data_type_match(deref_type, data_types.t_void) == DT_NOT_MATCH) {
+				return deref_type;
+			}
+		}
+		break;
+		
+	case T_AMPERSAND:
+		if (!right_type->is_array &&
+			(expr->unary.right->type == E_VARIABLE_REF ||
+			 expr->unary.right->type == E_ARRAY_ACCESS ||
+			 expr->unary.right->type == E_MEMBER_ACCESS ||
+			 (expr->unary.right->type == E_UNARY &&
+			  expr->unary.right->unary.op->type == T_CARET))) {
+			return data_type_canonical(right_type->identifier->lexeme,
+									   right_type->pointer_count + 1,
+									   false,
+									   null);
+		}
+		break;
+		
+	default:
+		assert(0);
+		break;
+	}
+
+	error_token(op,
+				"operator ‘%s’ cannot operate on type ‘%s’;",
+				op->lexeme,
+				data_type_to_string(right_type));
+	return null;
 }
 
 DataType* Resolve::resolve_cast_expr(Expr* expr) {
@@ -312,19 +571,8 @@ DataType* Resolve::resolve_cast_expr(Expr* expr) {
 
 	if (cast_type->pointer_count == right_type->pointer_count) {
 		if (cast_type->pointer_count == 0) {
-			bool cast_is_custom_type = true;
-			bool right_is_custom_type = true;
-			for (u64 i = 0; i < BUILT_IN_TYPES_LEN; i++) {
-				if (str_intern(cast_type->identifier->lexeme) ==
-					str_intern(built_in_types[i])) {
-					cast_is_custom_type = false;
-				}
-
-				if (str_intern(right_type->identifier->lexeme) ==
-					str_intern(built_in_types[i])) {
-					right_is_custom_type = false;
-				}				
-			}
+			bool cast_is_custom_type = !is_built_in_type(cast_type->identifier->lexeme);
+			bool right_is_custom_type = !is_built_in_type(right_type->identifier->lexeme);
 
 			if (cast_is_custom_type) {
 				error_data_type(cast_type,
@@ -349,6 +597,38 @@ DataType* Resolve::resolve_cast_expr(Expr* expr) {
 }
 
 DataType* Resolve::resolve_func_call(Expr* expr) {
+	Expr* left = expr->func_call.left;
+	if (left->type == E_MEMBER_ACCESS) {
+		CURRENT_ERROR;
+		DataType* struct_type = resolve_expr(left->member_access.left);
+		EXIT_ERROR(null);
+
+		Token* function_name = left->member_access.right;
+		StructFunctionMap* map = struct_of(struct_type);
+		Stmt* function = (map ?
+						  (Stmt*)map_get(&map->function_map, function_name->lexeme) :
+						  null);
+		if (!function) {
+			error_token(function_name,
+						"type ‘%s’ has no function ‘%s’;",
+						data_type_to_string(struct_type),
+						function_name->lexeme);
+			return null;
+		}
+
+		u64 arg_len = buf_len(expr->func_call.args);
+		u64 param_len = buf_len(function->func_decl.params);
+		if (arg_len != param_len) {
+			error_token(function_name,
+						"function ‘%s’ expects %lu arguments, but given %lu;",
+						function_name->lexeme,
+						param_len,
+						arg_len);
+			return null;
+		}
+		expr->func_call.function_called = function;
+	}
+
 	Stmt** params = expr->func_call.function_called->func_decl.params;
 	Expr** args = expr->func_call.args;
 	bool error_here = false;
@@ -372,14 +652,71 @@ DataType* Resolve::resolve_func_call(Expr* expr) {
 	return expr->func_call.function_called->func_decl.return_data_type;
 }
 
-DataType* Resolve::resolve_array_access(Expr* expr) {	
+DataType* Resolve::resolve_array_access(Expr* expr) {
+	CURRENT_ERROR;
+	DataType* left_type = resolve_expr(expr->array_access.left);
+	DataType* index_type = resolve_expr(expr->array_access.index);
+	EXIT_ERROR(null);
+
+	if (data_type_integer(index_type) == DT_NOT_MATCH) {
+		error_expr(expr->array_access.index,
+				   "array index must be an integer, but got ‘%s’;",
+				   data_type_to_string(index_type));
+		return null;
+	}
+
+	if (left_type->is_array) {
+		return data_type_canonical(left_type->identifier->lexeme,
+								   left_type->pointer_count,
+								   false,
+								   null);
+	}
+	if (left_type->pointer_count != 0 &&
+		data_type_match(left_type, data_types.t_void_pointer) == DT_NOT_MATCH) {
+		return data_type_canonical(left_type->identifier->lexeme,
+								   left_type->pointer_count - 1,
+								   false,
+								   null);
+	}
+	
+	error_expr(expr->array_access.left,
+			   "cannot index type ‘%s’;",
+			   data_type_to_string(left_type));
+	return null;
 }
 
 DataType* Resolve::resolve_member_access(Expr* expr) {
+	CURRENT_ERROR;
+	DataType* left_type = resolve_expr(expr->member_access.left);
+	EXIT_ERROR(null);
+
+	Token* member = expr->member_access.right;
+	StructFunctionMap* map = struct_of(left_type);
+	if (map) {
+		Stmt** fields = map->stmt->struct_stmt.fields;
+		buf_loop(fields, f) {
+			if (is_token_equal(fields[f]->var_decl.identifier, member)) {
+				expr->member_access.field = fields[f];
+				return fields[f]->var_decl.data_type;
+			}
+		}
+	}
+
+	error_token(member,
+				"type ‘%s’ has no field ‘%s’;",
+				data_type_to_string(left_type),
+				member->lexeme);
+	return null;
 }
 
 DataType* Resolve::resolve_variable_ref(Expr* expr) {
-	return expr->variable_ref.variable_refed->var_decl.data_type;
+	DataType* data_type = expr->variable_ref.variable_refed->var_decl.data_type;
+	if (!data_type) {
+		/* the type could not be inferred; that error has already been
+		 * reported, so just stop here */
+		error_count++;
+	}
+	return data_type;
 }
 
 DataType* Resolve::resolve_number_expr(Expr* expr) {
@@ -394,70 +731,31 @@ DataType* Resolve::resolve_number_expr(Expr* expr) {
 }
 
 DataType* Resolve::resolve_constant_expr(Expr* expr) {
-	if (str_intern(expr->constant->lexeme) ==
-		str_intern("true") ||
-		str_intern(expr->constant->lexeme) ==
-		str_intern("false")) {
+	switch (expr->constant->keyword) {
+	case KW_TRUE:
+	case KW_FALSE:
 		return data_types.t_bool;
-	}
-	else if (str_intern(expr->constant->lexeme) ==
-			 str_intern("null")) {
+	case KW_NULL:
 		return data_types.t_void_pointer;
+	default: break;
 	}
 	return null;
 }	
 
-char* Resolve::data_type_to_string(DataType* data_type) {
-	/* TODO: this is highly inefficient; use maps */
-	u64 main_type_len = strlen(data_type->identifier->lexeme);
-	u64 len = main_type_len + data_type->pointer_count;
-	u64 array_elem_count_len = 0;
-	if (data_type->is_array) {
-		array_elem_count_len = strlen(data_type->array_elem_count->lexeme);
-		len += 2;
-		len += array_elem_count_len;
-	}
-
-	u64 idx = 0;
-	char* str = (char*)malloc(len + 1);
-	
-	if (data_type->is_array) {
-		str[0] = '[';
-		idx++;
-		strncpy(str + idx, data_type->array_elem_count->lexeme, array_elem_count_len);
-		idx += array_elem_count_len;
-		str[idx] = ']';
-	}
-
-	for (u8 i = 0; i < data_type->pointer_count; ++i) {
-		str[idx] = '^';
-		idx++;
-	}
-
-	strncpy(str + idx, data_type->identifier->lexeme, main_type_len);
-	
-	str[len] = '\0';
-	buf_push(data_type_strings, str);
-	return str;
-
-}
-
-void Resolve::error_root(SourceFile* srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap) {
+void Resolve::error_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
 	print_error_at(
 		srcfile,
-		line,
-		column,
+		offset,
 		char_count,
 		fmt,
 		ap);
 	error_count++;
 }
 
-void Resolve::warning_root(SourceFile* srcfile, u64 line, u64 column, u64 char_count, const char* fmt, va_list ap) {
+void Resolve::warning_root(SourceFile* srcfile, u64 offset, u64 char_count, const char* fmt, va_list ap) {
 	print_warning_at(
 		srcfile,
-		line,
-		column,
+		offset,
 		char_count,
 		fmt,
 		ap);
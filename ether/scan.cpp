@@ -0,0 +1,145 @@
+#include <ether.hpp>
+#include <scan.hpp>
+
+#if LEXER_SIMD && defined(__x86_64__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#else
+#define SCAN_X86 0
+#endif
+
+Scanners scanners;
+
+static char* skip_class_scalar(char* c, u8 cls) {
+	while (is_char_class(*c, cls)) {
+		c++;
+	}
+	return c;
+}
+
+static char* skip_whitespace_scalar(char* c) {
+	return skip_class_scalar(c, CC_WHITESPACE);
+}
+
+static char* skip_identifier_scalar(char* c) {
+	return skip_class_scalar(c, CC_IDENTIFIER);
+}
+
+static char* skip_string_body_scalar(char* c) {
+	while (*c != '"' && *c != '\0') {
+		c++;
+	}
+	return c;
+}
+
+#if SCAN_X86
+/* SSE2 only has signed byte compares, so ranges are checked by biasing
+ * the lower bound to -128 and comparing against -128 + range length */
+#define RANGE_BIAS(lo) ((char)(0x80 - (lo)))
+#define RANGE_LIMIT(len) ((char)(-128 + (len)))
+
+static inline __m128i whitespace_mask_sse2(__m128i v) {
+	__m128i m = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+	m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+	m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+	m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+	return m;
+}
+
+static inline __m128i identifier_mask_sse2(__m128i v) {
+	__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	__m128i alpha = _mm_cmplt_epi8(_mm_add_epi8(lower, _mm_set1_epi8(RANGE_BIAS('a'))),
+								   _mm_set1_epi8(RANGE_LIMIT(26)));
+	__m128i digit = _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8(RANGE_BIAS('0'))),
+								   _mm_set1_epi8(RANGE_LIMIT(10)));
+	__m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+	return _mm_or_si128(_mm_or_si128(alpha, digit), underscore);
+}
+
+static inline __m128i string_end_mask_sse2(__m128i v) {
+	return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+						_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+}
+
+/* a vector only advances when every byte is in the run, so no load
+ * starts past the sentinel and none reads beyond the padding */
+#define SCAN_SSE2(name, in_run_mask)									\
+	static char* name##_sse2(char* c) {									\
+		for (;;) {														\
+			__m128i v = _mm_loadu_si128((const __m128i*)c);				\
+			u32 stop = ~(u32)_mm_movemask_epi8(in_run_mask(v)) & 0xffff; \
+			if (stop) return c + __builtin_ctz(stop);					\
+			c += 16;													\
+		}																\
+	}
+
+#define NOT_MASK_SSE2(mask) _mm_xor_si128(mask, _mm_set1_epi8(-1))
+
+SCAN_SSE2(skip_whitespace, whitespace_mask_sse2)
+SCAN_SSE2(skip_identifier, identifier_mask_sse2)
+#define string_body_mask_sse2(v) NOT_MASK_SSE2(string_end_mask_sse2(v))
+SCAN_SSE2(skip_string_body, string_body_mask_sse2)
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i whitespace_mask_avx2(__m256i v) {
+	__m256i m = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+	m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+	m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+	m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+	return m;
+}
+
+AVX2 static inline __m256i identifier_mask_avx2(__m256i v) {
+	__m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+	__m256i alpha = _mm256_cmpgt_epi8(_mm256_set1_epi8(RANGE_LIMIT(26)),
+									  _mm256_add_epi8(lower, _mm256_set1_epi8(RANGE_BIAS('a'))));
+	__m256i digit = _mm256_cmpgt_epi8(_mm256_set1_epi8(RANGE_LIMIT(10)),
+									  _mm256_add_epi8(v, _mm256_set1_epi8(RANGE_BIAS('0'))));
+	__m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+	return _mm256_or_si256(_mm256_or_si256(alpha, digit), underscore);
+}
+
+AVX2 static inline __m256i string_body_mask_avx2(__m256i v) {
+	__m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+								   _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+	return _mm256_xor_si256(stop, _mm256_set1_epi8(-1));
+}
+
+#define SCAN_AVX2(name, in_run_mask)									\
+	AVX2 static char* name##_avx2(char* c) {							\
+		for (;;) {														\
+			__m256i v = _mm256_loadu_si256((const __m256i*)c);			\
+			u32 stop = ~(u32)_mm256_movemask_epi8(in_run_mask(v));		\
+			if (stop) return c + __builtin_ctz(stop);					\
+			c += 32;													\
+		}																\
+	}
+
+SCAN_AVX2(skip_whitespace, whitespace_mask_avx2)
+SCAN_AVX2(skip_identifier, identifier_mask_avx2)
+SCAN_AVX2(skip_string_body, string_body_mask_avx2)
+#endif
+
+void sys_scanners_init() {
+	scanners.skip_whitespace = skip_whitespace_scalar;
+	scanners.skip_identifier = skip_identifier_scalar;
+	scanners.skip_string_body = skip_string_body_scalar;
+	scanners.name = "scalar";
+
+#if SCAN_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		scanners.skip_whitespace = skip_whitespace_avx2;
+		scanners.skip_identifier = skip_identifier_avx2;
+		scanners.skip_string_body = skip_string_body_avx2;
+		scanners.name = "avx2";
+	}
+	else if (__builtin_cpu_supports("sse2")) {
+		scanners.skip_whitespace = skip_whitespace_sse2;
+		scanners.skip_identifier = skip_identifier_sse2;
+		scanners.skip_string_body = skip_string_body_sse2;
+		scanners.name = "sse2";
+	}
+#endif
+}
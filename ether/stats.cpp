@@ -0,0 +1,357 @@
+#include <ether.hpp>
+#include <stats.hpp>
+#include <token.hpp>
+#include <stmt.hpp>
+#include <expr.hpp>
+
+#define TOKEN_TYPE_COUNT (T_EOF + 1)
+#define STMT_TYPE_COUNT (S_BLOCK + 1)
+#define EXPR_TYPE_COUNT (E_CONSTANT + 1)
+
+StatsFlags stats_flags;
+
+static const char* token_type_names[TOKEN_TYPE_COUNT] = {
+	"identifier",
+	"keyword",
+	"string",
+	"char",
+	"integer",
+	"float32",
+	"float64",
+
+	"lparen",
+	"rparen",
+	"lbrace",
+	"rbrace",
+	"lbracket",
+	"rbracket",
+	"langbkt",
+	"rangbkt",
+	"plus",
+	"minus",
+	"asterisk",
+	"slash",
+	"percent",
+	"bang",
+	"equal",
+	"ampersand",
+	"bar",
+	"tilde",
+	"colon",
+	"semicolon",
+	"comma",
+	"dot",
+	"caret",
+	"pound",
+
+	"double_colon",
+	"plus_equal",
+	"minus_equal",
+	"asterisk_equal",
+	"slash_equal",
+	"percent_equal",
+	"bang_equal",
+	"less_equal",
+	"greater_equal",
+	"less_less",
+	"greater_greater",
+	"equal_equal",
+	"ampersand_ampersand",
+	"bar_bar",
+	"ampersand_equal",
+	"bar_equal",
+	"dot_dot",
+	"arrow",
+
+	"less_less_equal",
+	"greater_greater_equal",
+
+	"eof",
+};
+
+static const char* stmt_type_names[STMT_TYPE_COUNT] = {
+	"struct",
+	"func_decl",
+	"var_decl",
+	"if",
+	"for",
+	"switch",
+	"return",
+	"expr_stmt",
+	"block",
+};
+
+static const char* expr_type_names[EXPR_TYPE_COUNT] = {
+	"binary",
+	"unary",
+	"cast",
+	"func_call",
+	"array_access",
+	"member_access",
+	"variable_ref",
+	"number",
+	"string",
+	"char",
+	"constant",
+};
+
+/* counts of one thread, added up only in stats_report once every
+ * worker is done, so counting never contends for a cache line */
+struct ThreadStats {
+	u64 counters[_STAT_COUNT];
+	u64 tokens[TOKEN_TYPE_COUNT];
+	u64 stmts[STMT_TYPE_COUNT];
+	u64 exprs[EXPR_TYPE_COUNT];
+};
+
+static ThreadStats** thread_stats_list = null;
+static thread_local ThreadStats* thread_stats = null;
+static std::mutex thread_stats_mutex;
+
+static ThreadStats* get_thread_stats() {
+	if (!thread_stats) {
+		thread_stats = new ThreadStats();
+		std::lock_guard<std::mutex> lock(thread_stats_mutex);
+		buf_push(thread_stats_list, thread_stats);
+	}
+	return thread_stats;
+}
+
+void stats_add_slow(StatCounter counter, u64 n) {
+	get_thread_stats()->counters[counter] += n;
+}
+
+/* only once every worker is done */
+u64 stats_total(StatCounter counter) {
+	u64 total = 0;
+	buf_loop(thread_stats_list, t) {
+		total += thread_stats_list[t]->counters[counter];
+	}
+	return total;
+}
+
+void stats_count_tokens(Token* tokens) {
+	if (!stats_flags.enabled) {
+		return;
+	}
+
+	ThreadStats* stats = get_thread_stats();
+	buf_loop(tokens, t) {
+		stats->tokens[tokens[t].type]++;
+	}
+}
+
+static void count_stmt(ThreadStats* stats, Stmt* stmt);
+static void count_stmts(ThreadStats* stats, Stmt** stmts);
+
+static void count_expr(ThreadStats* stats, Expr* expr) {
+	if (!expr) {
+		return;
+	}
+
+	stats->exprs[expr->type]++;
+	switch (expr->type) {
+	case E_BINARY:
+		count_expr(stats, expr->binary.left);
+		count_expr(stats, expr->binary.right);
+		break;
+	case E_UNARY:
+		count_expr(stats, expr->unary.right);
+		break;
+	case E_CAST:
+		count_expr(stats, expr->cast.right);
+		break;
+	case E_FUNC_CALL:
+		count_expr(stats, expr->func_call.left);
+		buf_loop(expr->func_call.args, a) {
+			count_expr(stats, expr->func_call.args[a]);
+		}
+		break;
+	case E_ARRAY_ACCESS:
+		count_expr(stats, expr->array_access.left);
+		count_expr(stats, expr->array_access.index);
+		break;
+	case E_MEMBER_ACCESS:
+		count_expr(stats, expr->member_access.left);
+		break;
+	case E_VARIABLE_REF:
+	case E_NUMBER:
+	case E_STRING:
+	case E_CHAR:
+	case E_CONSTANT:
+		break;
+	}
+}
+
+static void count_stmt(ThreadStats* stats, Stmt* stmt) {
+	if (!stmt) {
+		return;
+	}
+
+	stats->stmts[stmt->type]++;
+	switch (stmt->type) {
+	case S_STRUCT:
+		count_stmts(stats, stmt->struct_stmt.fields);
+		break;
+	case S_FUNC_DECL:
+		count_stmts(stats, stmt->func_decl.params);
+		count_stmts(stats, stmt->func_decl.body);
+		break;
+	case S_VAR_DECL:
+		count_expr(stats, stmt->var_decl.initializer);
+		break;
+	case S_IF:
+		count_expr(stats, stmt->if_stmt.if_branch->cond);
+		count_stmts(stats, stmt->if_stmt.if_branch->body);
+		buf_loop(stmt->if_stmt.elif_branch, b) {
+			count_expr(stats, stmt->if_stmt.elif_branch[b]->cond);
+			count_stmts(stats, stmt->if_stmt.elif_branch[b]->body);
+		}
+		if (stmt->if_stmt.else_branch) {
+			count_stmts(stats, stmt->if_stmt.else_branch->body);
+		}
+		break;
+	case S_FOR:
+		count_stmt(stats, stmt->for_stmt.counter);
+		count_expr(stats, stmt->for_stmt.end);
+		count_stmts(stats, stmt->for_stmt.body);
+		break;
+	case S_SWITCH:
+		count_expr(stats, stmt->switch_stmt.cond);
+		buf_loop(stmt->switch_stmt.branches, b) {
+			SwitchBranch* branch = stmt->switch_stmt.branches[b];
+			buf_loop(branch->conds, c) {
+				count_expr(stats, branch->conds[c]);
+			}
+			count_stmt(stats, branch->stmt);
+		}
+		break;
+	case S_RETURN:
+		count_expr(stats, stmt->return_stmt.to_return);
+		break;
+	case S_EXPR_STMT:
+		count_expr(stats, stmt->expr_stmt);
+		break;
+	case S_BLOCK:
+		count_stmts(stats, stmt->block);
+		break;
+	}
+}
+
+static void count_stmts(ThreadStats* stats, Stmt** stmts) {
+	buf_loop(stmts, s) {
+		count_stmt(stats, stmts[s]);
+	}
+}
+
+/* the tree as parsed; the copies of a unit's decls that its importers
+ * get are not counted again */
+void stats_count_ast(Stmt** stmts) {
+	if (!stats_flags.enabled) {
+		return;
+	}
+	count_stmts(get_thread_stats(), stmts);
+}
+
+static double ratio(u64 a, u64 b) {
+	return (b ? (double)a / b : 0.0);
+}
+
+static u64 sum(u64* counts, u64 len) {
+	u64 total = 0;
+	for (u64 i = 0; i < len; i++) {
+		total += counts[i];
+	}
+	return total;
+}
+
+static void print_counts_text(const char* title, u64* counts, const char** labels, u64 len) {
+	fprintf(stderr, "  %-24s %12lu\n", title, sum(counts, len));
+	for (u64 i = 0; i < len; i++) {
+		if (counts[i]) {
+			fprintf(stderr, "    %-22s %12lu\n", labels[i], counts[i]);
+		}
+	}
+}
+
+static void print_counts_json(const char* title, u64* counts, const char** labels, u64 len) {
+	fprintf(stderr, "\"%s\":{\"total\":%lu", title, sum(counts, len));
+	for (u64 i = 0; i < len; i++) {
+		fprintf(stderr, ",\"%s\":%lu", labels[i], counts[i]);
+	}
+	fprintf(stderr, "}");
+}
+
+void stats_report() {
+	if (!stats_flags.counting) {
+		return;
+	}
+
+	/* nothing is counted past here, so the per-thread counts can go */
+	stats_flags.counting = false;
+	ThreadStats total = {};
+	buf_loop(thread_stats_list, t) {
+		ThreadStats* stats = thread_stats_list[t];
+		for (u64 c = 0; c < _STAT_COUNT; c++) total.counters[c] += stats->counters[c];
+		for (u64 i = 0; i < TOKEN_TYPE_COUNT; i++) total.tokens[i] += stats->tokens[i];
+		for (u64 i = 0; i < STMT_TYPE_COUNT; i++) total.stmts[i] += stats->stmts[i];
+		for (u64 i = 0; i < EXPR_TYPE_COUNT; i++) total.exprs[i] += stats->exprs[i];
+		delete stats;
+	}
+	buf_free(thread_stats_list);
+	if (!stats_flags.enabled) {
+		return;
+	}
+
+	u64 intern_count, intern_bytes, intern_blocks;
+	str_intern_stats(&intern_count, &intern_bytes, &intern_blocks);
+	u64* c = total.counters;
+
+	std::lock_guard<std::mutex> lock(output_mutex);
+	if (stats_flags.format == STATS_JSON) {
+		fprintf(stderr, "{");
+		print_counts_json("tokens", total.tokens, token_type_names, TOKEN_TYPE_COUNT);
+		fprintf(stderr, ",");
+		print_counts_json("stmts", total.stmts, stmt_type_names, STMT_TYPE_COUNT);
+		fprintf(stderr, ",");
+		print_counts_json("exprs", total.exprs, expr_type_names, EXPR_TYPE_COUNT);
+		fprintf(stderr, ",\"interner\":{\"lookups\":%lu,\"hits\":%lu,\"collisions\":%lu,"
+				"\"strings\":%lu,\"bytes\":%lu}",
+				c[STAT_INTERN_LOOKUPS], c[STAT_INTERN_HITS], c[STAT_INTERN_COLLISIONS],
+				intern_count, intern_bytes);
+		fprintf(stderr, ",\"buf\":{\"grows\":%lu,\"bytes_copied\":%lu,\"bytes_grown\":%lu}",
+				c[STAT_BUF_GROWS], c[STAT_BUF_BYTES_COPIED], c[STAT_BUF_BYTES_GROWN]);
+		fprintf(stderr, ",\"scopes\":{\"lookups\":%lu,\"misses\":%lu,\"depth\":%lu}",
+				c[STAT_SCOPE_LOOKUPS], c[STAT_SCOPE_MISSES], c[STAT_SCOPE_DEPTH]);
+		fprintf(stderr, ",\"data_type_match\":{\"calls\":%lu}}\n",
+				c[STAT_DATA_TYPE_MATCHES]);
+		return;
+	}
+
+	fprintf(stderr, "\nstatistics\n");
+	print_counts_text("tokens", total.tokens, token_type_names, TOKEN_TYPE_COUNT);
+	print_counts_text("stmts", total.stmts, stmt_type_names, STMT_TYPE_COUNT);
+	print_counts_text("exprs", total.exprs, expr_type_names, EXPR_TYPE_COUNT);
+
+	fprintf(stderr, "  %-24s %12lu\n", "interner lookups", c[STAT_INTERN_LOOKUPS]);
+	fprintf(stderr, "    %-22s %12lu  %6.1f%%\n", "hits",
+			c[STAT_INTERN_HITS],
+			100.0 * ratio(c[STAT_INTERN_HITS], c[STAT_INTERN_LOOKUPS]));
+	fprintf(stderr, "    %-22s %12lu  %6.2f per lookup\n", "collisions",
+			c[STAT_INTERN_COLLISIONS],
+			ratio(c[STAT_INTERN_COLLISIONS], c[STAT_INTERN_LOOKUPS]));
+	fprintf(stderr, "    %-22s %12lu\n", "strings", intern_count);
+	fprintf(stderr, "    %-22s %12lu\n", "bytes", intern_bytes);
+
+	fprintf(stderr, "  %-24s %12lu\n", "buf grows", c[STAT_BUF_GROWS]);
+	fprintf(stderr, "    %-22s %12lu\n", "bytes copied", c[STAT_BUF_BYTES_COPIED]);
+	fprintf(stderr, "    %-22s %12lu\n", "bytes grown", c[STAT_BUF_BYTES_GROWN]);
+
+	fprintf(stderr, "  %-24s %12lu\n", "scope lookups", c[STAT_SCOPE_LOOKUPS]);
+	fprintf(stderr, "    %-22s %12lu\n", "misses", c[STAT_SCOPE_MISSES]);
+	fprintf(stderr, "    %-22s %12lu  %6.2f per hit\n", "depth",
+			c[STAT_SCOPE_DEPTH],
+			ratio(c[STAT_SCOPE_DEPTH], c[STAT_SCOPE_LOOKUPS] - c[STAT_SCOPE_MISSES]));
+
+	fprintf(stderr, "  %-24s %12lu\n", "data_type_match calls", c[STAT_DATA_TYPE_MATCHES]);
+}
@@ -1,24 +1,97 @@
 #include <ether.hpp>
 #include <str_intern.hpp>
+#include <stats.hpp>
 
-static StrIntern* interns;
+#include <mutex>
 
-char* str_intern_range(char* start, char* end) {
-	u64 len = end - start;
-	buf_loop(interns, i) {
-		if (interns[i].len == len &&
-			strncmp(interns[i].str, start, len) == false) {
-			return interns[i].str;
+#define INTERNS_MIN_CAP 1024
+#define INTERN_SHARD_BITS 4
+#define INTERN_SHARD_COUNT (1 << INTERN_SHARD_BITS)
+
+/* the interner is split into shards picked by the top bits of the hash.
+ * an entry's key is its str and its sub_key its length. lookups probe
+ * the shard's map without locking; only inserts take the lock */
+struct InternShard {
+	std::mutex mutex;
+	SharedMap map = { null, 0, INTERNS_MIN_CAP, null };
+	/* backing storage for the interned bytes; never freed */
+	Arena arena;
+};
+
+static InternShard shards[INTERN_SHARD_COUNT];
+
+/* inlined into both callers: as a call it added about 3 ns to every hit */
+static inline __attribute__((always_inline)) char* intern_table_find(SharedTable* table, char* start, u64 len, u64 hash) {
+	u64 collisions;
+	SharedEntry* entry = shared_table_find(table, hash, &collisions, [&](void* key, SharedEntry* e) {
+		return (u64)e->sub_key == len && memcmp(key, start, len) == 0;
+	});
+	STAT_ADD(STAT_INTERN_COLLISIONS, collisions);
+	return (entry ? (char*)entry->key : null);
+}
+
+/* the caller holds the shard's lock, or is the only thread running */
+static char* str_intern_insert(InternShard* shard, char* start, u64 len, u64 hash) {
+	/* another thread may have inserted it since the unlocked probe */
+	if (shard->map.table) {
+		char* str = intern_table_find(shard->map.table, start, len, hash);
+		if (str) {
+			STAT_INC(STAT_INTERN_HITS);
+			return str;
 		}
 	}
 
-	char* str = (char*)malloc(len + 1);
+	char* str = (char*)arena_alloc_aligned(&shard->arena, len + 1, 1);
 	memcpy(str, start, len);
 	str[len] = 0;
-	buf_push(interns, (StrIntern){ str, len });
+	shared_map_put(&shard->map, hash, str, (void*)len, null);
 	return str;
 }
 
+char* str_intern_range(char* start, char* end) {
+	u64 len = end - start;
+	u64 hash = hash_bytes(start, len);
+	InternShard* shard = &shards[hash >> (64 - INTERN_SHARD_BITS)];
+	STAT_INC(STAT_INTERN_LOOKUPS);
+
+	SharedTable* table = shared_map_table(&shard->map);
+	if (table) {
+		char* str = intern_table_find(table, start, len, hash);
+		if (str) {
+			STAT_INC(STAT_INTERN_HITS);
+			return str;
+		}
+	}
+
+	if (!threads_running) {
+		return str_intern_insert(shard, start, len, hash);
+	}
+	std::lock_guard<std::mutex> lock(shard->mutex);
+	return str_intern_insert(shard, start, len, hash);
+}
+
 char* str_intern(char* str) {
 	return str_intern_range(str, str + strlen(str));
 }
+
+/* the probe tables, retired ones included */
+u64 str_intern_table_bytes() {
+	u64 bytes = 0;
+	for (u64 s = 0; s < INTERN_SHARD_COUNT; s++) {
+		std::lock_guard<std::mutex> lock(shards[s].mutex);
+		bytes += shared_map_bytes(&shards[s].map);
+	}
+	return bytes;
+}
+
+void str_intern_stats(u64* count, u64* bytes, u64* blocks) {
+	*count = 0;
+	*bytes = 0;
+	*blocks = 0;
+	for (u64 s = 0; s < INTERN_SHARD_COUNT; s++) {
+		std::lock_guard<std::mutex> lock(shards[s].mutex);
+		*count += shards[s].map.len;
+		*bytes += shards[s].arena.bytes_allocated;
+		*blocks += buf_len(shards[s].arena.blocks);
+	}
+}
@@ -1,34 +1,39 @@
 #include <ether.hpp>
 #include <token.hpp>
+#include <ast_arena.hpp>
 
-Token* token_create(char* lexeme, char* start, char* end, TokenType type, SourceFile* file, u64 line, u64 column, u64 char_count) {
-	Token* token = new Token();
+Token* token_create(AstArena* ast_arena, char* lexeme, u64 offset, u32 char_count, TokenType type, u16 file_id) {
+#ifdef _DEBUG
+	/* names are compared by pointer everywhere past the lexer */
+	assert(lexeme == str_intern(lexeme));
+#endif
+	Token* token = AST_NEW(ast_arena, AST_TOKEN, Token);
 	token->lexeme = lexeme;
-	token->start = start;
-	token->end = end;
-	token->type = type;
-	token->file = file;
-	token->line = line;
-	token->column = column;
+	token->offset = offset;
 	token->char_count = char_count;
+	token->file_id = file_id;
+	token->type = type;
+	token->keyword = KW_NONE;
 	return token;
 }
 
-Token* token_from_string(char* lexeme) {
-	return token_create(lexeme,
-						lexeme,
-						lexeme,
-						T_KEYWORD,
-						null,
+Token* token_from_string(AstArena* ast_arena, char* lexeme) {
+	return token_create(ast_arena,
+						str_intern(lexeme),
 						0,
 						0,
-						0);
+						T_KEYWORD,
+						SOURCE_FILE_NONE);
+}
+
+SourceFile* token_file(Token* token) {
+	return source_file_from_id(token->file_id);
+}
+
+u64 token_end(Token* token) {
+	return token->offset + token->char_count;
 }
 
 bool is_token_equal(Token* a, Token* b) {
-	if (str_intern(a->lexeme) ==
-		str_intern(b->lexeme)) {
-		return true;	
-	}
-	return false;
+	return a->lexeme == b->lexeme;
 }